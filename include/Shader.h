@@ -1,18 +1,90 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include "shader_preprocessor.h"
 #include <glad/glad.h>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <glm/glm.hpp>
 
+// Raw uploads behind Uniform<T>; the owning program must be in use.
+void uploadUniform(GLint location, bool value);
+void uploadUniform(GLint location, int value);
+void uploadUniform(GLint location, float value);
+void uploadUniform(GLint location, const glm::vec2& value);
+void uploadUniform(GLint location, const glm::vec3& value);
+void uploadUniform(GLint location, const glm::mat4& value);
+
+// Typed handle to a uniform location. Remembers the last value it uploaded and
+// skips the GL call when the value has not changed.
+template <typename T>
+class Uniform {
+public:
+    GLint Location = -1;
+
+    Uniform() = default;
+    explicit Uniform(GLint location) : Location(location) {}
+
+    void set(const T& value) {
+        if (Location < 0 || (valid && value == last))
+            return;
+        uploadUniform(Location, value);
+        last = value;
+        valid = true;
+    }
+
+    // Forces the next set() to upload, e.g. after the program was relinked.
+    void invalidate() { valid = false; }
+
+private:
+    T last{};
+    bool valid = false;
+};
+
 class Shader {
 public:
     GLuint ID;
 
-    Shader(const char* vertexPath, const char* fragmentPath);
+    // Preprocesses both files with the given defines, then loads the linked
+    // program from the binary cache or compiles and links it. With async set
+    // the link may still be running when this returns; poll ready() before use.
+    Shader(const char* vertexPath, const char* fragmentPath, bool async = false,
+           const ShaderDefines& defines = ShaderDefines());
     ~Shader();
 
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+
+    // Builds a program from in-memory sources without touching the cache.
+    static std::unique_ptr<Shader> fromSource(const std::string& vertexCode, const std::string& fragmentCode);
+
+    // Directory for cached program binaries; empty disables the cache.
+    static void setCacheDirectory(const std::string& path);
+
+    // True once linking has finished. Does not block when the driver has
+    // KHR_parallel_shader_compile; otherwise completes the link in place.
+    bool ready();
+    // Blocks until linking has finished.
+    void wait();
+    // Whether the finished link succeeded.
+    bool linked() const { return linkSucceeded; }
+    // Whether the program came from the binary cache instead of a compile.
+    bool fromCache() const { return cached; }
+
     void use() const;
+
+    // Location from the table filled at link time; -1 for unknown or inactive uniforms.
+    GLint uniformLocation(const std::string& name) const;
+
+    template <typename T>
+    Uniform<T> uniform(const std::string& name) const {
+        return Uniform<T>(uniformLocation(name));
+    }
+
+    // Attaches a uniform block to a binding point; false when the program has no such block.
+    bool bindUniformBlock(const std::string& name, GLuint binding) const;
+
     void setBool(const std::string& name, bool value) const;
     void setInt(const std::string& name, int value) const;
     void setFloat(const std::string& name, float value) const;
@@ -21,8 +93,23 @@ public:
     void setMat4(const std::string& name, const glm::mat4& mat) const;
 
 private:
+    std::unordered_map<std::string, GLint> locations;
+    GLuint pendingVertex = 0;
+    GLuint pendingFragment = 0;
+    bool pending = false;
+    bool linkSucceeded = false;
+    bool cached = false;
+    std::string binaryPath;
+
+    Shader() : ID(0) {}
+
+    void build(const std::string& vertexCode, const std::string& fragmentCode, bool async, bool useCache);
+    void finishLink();
+    bool loadBinary();
+    void saveBinary() const;
+    void cacheUniformLocations();
     void checkCompileErrors(GLuint shader, const std::string& type);
-    std::string readFile(const char* filePath);
+    std::string readSource(const char* filePath, const ShaderDefines& defines);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef BRICK_MAP_H
+#define BRICK_MAP_H
+
+#include "distance_bound.h"
+#include "fractal.h"
+#include "thread_pool.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Sparse two-level distance field over the bounding cube. A cells^3 index
+// grid holds one conservative bound per cell; cells where that bound is
+// shorter than the cell itself, i.e. near the surface, also get a brick of
+// BRICK_SIZE^3 8-bit samples. Empty space thus costs one float per cell and
+// the surface is resolved at cells * BRICK_SIZE samples per side.
+//
+// Samples are the smallest estimate over the whole iteration counts up to
+// iterations, lowered by half a voxel diagonal and rounded down when
+// quantised, so the voxel containing a point bounds the estimate there.
+//
+// A symmetric map keeps only the cells of one octant with i >= j >= k, the
+// fundamental domain of the Mandelbox's symmetries (see symmetryFold()), and
+// folds every lookup into it. cells is then even, so cell faces lie on the
+// mirror planes.
+class BrickMap : public DistanceBound {
+public:
+    static const int BRICK_SIZE = 8;
+
+    // symmetric rounds cells up to even.
+    void build(int cells, int iterations, ThreadPool& pool, bool symmetric = false);
+
+    bool save(const std::string& path) const;
+    // Reads a file written by save(); fails if it was built with different
+    // Mandelbox constants or file version.
+    bool read(const std::string& path);
+
+    // Reads the cached build for these settings from directory, building and
+    // saving it first when there is none. An empty directory builds without
+    // caching.
+    bool load(const std::string& directory, int cells, int iterations, ThreadPool& pool,
+              bool symmetric = false);
+
+    static std::string cacheFileName(int cells, int iterations, bool symmetric = false);
+
+    bool empty() const { return cellCount == 0; }
+    int cells() const { return cellCount; }
+    int iterations() const { return count; }
+    bool symmetric() const { return folded; }
+    // Cells per axis the index spans: cells(), or half of it from the centre
+    // for a symmetric map.
+    int indexCells() const { return folded ? cellCount / 2 : cellCount; }
+    int brickCount() const { return static_cast<int>(bricks.size() / BRICK_VOXELS); }
+    float cellSize() const;
+    float voxelSize() const { return cellSize() / static_cast<float>(BRICK_SIZE); }
+
+    // One entry per cell, at cellIndex(): the bound anywhere in the cell, and
+    // the index of its brick or -1.
+    const std::vector<float>& cellBounds() const { return bounds; }
+    const std::vector<int32_t>& brickIndices() const { return indices; }
+    // Entry of cell c of the index, x fastest; a symmetric map packs the
+    // cells with c.x >= c.y >= c.z like DistanceVolume::wedgeIndex().
+    size_t cellIndex(const glm::ivec3& c) const;
+    // brickCount() bricks of BRICK_SIZE^3 samples, x fastest. Sample q bounds
+    // the estimate in its voxel by q / 255 * cellSize().
+    const std::vector<uint8_t>& brickData() const { return bricks; }
+
+    // Bytes held by the index and the bricks.
+    size_t memoryBytes() const;
+
+    bool covers(const FractalParams& params) const override {
+        return !empty() && params.maxIterations >= 1 && params.maxIterations <= count;
+    }
+    float minStep() const override { return voxelSize(); }
+    float lowerBound(const glm::vec3& objPos) const override;
+
+private:
+    static const int BRICK_VOXELS = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+
+    int cellCount = 0;
+    int count = 0;
+    bool folded = false;
+    std::vector<float> bounds;
+    std::vector<int32_t> indices;
+    std::vector<uint8_t> bricks;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef CAMERA_SCRIPT_H
+#define CAMERA_SCRIPT_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Camera and parameter state at one keyframe of a scripted flight.
+struct CameraKey {
+    int frame = 0;
+    glm::vec3 mantissa = glm::vec3(0.0f, 0.0f, 5.0f);
+    int exponent = -2;
+    float yaw = -90.0f;
+    float pitch = 0.0f;
+    int maxIterations = 16;
+    float time = 0.0f;
+};
+
+// Deterministic camera flight loaded from a JSON keyframe file:
+//   { "width": 1280, "height": 720, "frames": 600, "warmup": 30,
+//     "keyframes": [ { "frame": 0, "mantissa": [0, 0, 5], "exponent": -2,
+//                      "yaw": -90, "pitch": 0, "maxIterations": 16, "time": 0 }, ... ] }
+// Mantissa, yaw, pitch and time are interpolated linearly between keyframes;
+// exponent and maxIterations hold the value of the preceding keyframe.
+class CameraScript {
+public:
+    int Width = 1280;
+    int Height = 720;
+    int FrameCount = 600;
+    int WarmupFrames = 30;
+    std::vector<CameraKey> Keys;
+
+    bool load(const char* filePath, std::string& error);
+
+    CameraKey sample(int frame) const;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef CPU_RENDERER_H
+#define CPU_RENDERER_H
+
+#include "fractal.h"
+#include "thread_pool.h"
+#include <glm/glm.hpp>
+#include <atomic>
+#include <vector>
+
+// Tiled software renderer producing the same image as fragment.glsl.
+// Tiles are visited in Morton order and balanced across cores by a
+// work-stealing pool, since sky tiles cost a fraction of surface tiles.
+class CpuRenderer {
+public:
+    int TileSize = 32;
+    // Side in pixels of the blocks that share one cone in the depth prepass,
+    // as ShaderRenderer::PrepassTile; 0 marches every pixel from the camera.
+    // Matching the GL backend's value keeps the two images the same.
+    int PrepassTile = 8;
+    // MarchSettings::relaxation; 1 is the plain sphere tracer.
+    float Relaxation = 1.0f;
+    // MarchSettings::volume; null marches from the bounding cube.
+    const DistanceBound* Volume = nullptr;
+
+    explicit CpuRenderer(unsigned threadCount = 0);
+
+    unsigned threadCount() const { return pool.size(); }
+
+    // Fills pixels with view.width * view.height gamma-corrected colours,
+    // top row first.
+    void render(const ViewParams& view, std::vector<glm::vec3>& pixels);
+
+    // Mean distance estimates per pixel spent marching primary rays in the
+    // last render(); shading is not counted.
+    double evaluationsPerPixel() const { return lastEvaluationsPerPixel; }
+
+private:
+    ThreadPool pool;
+    std::vector<glm::ivec2> tiles;
+    int tilesWidth = 0;
+    int tilesHeight = 0;
+    int tilesSize = 0;
+    // Start depth and orbit trap per prepass block, bottom row first like
+    // the GL target.
+    std::vector<glm::vec2> prepass;
+    glm::ivec2 prepassBlocks = glm::ivec2(0);
+    std::atomic<long long> evaluations{0};
+    double lastEvaluationsPerPixel = 0.0;
+
+    void buildTiles(int width, int height);
+    void runPrepass(const ViewParams& view);
+    glm::vec2 prepassStart(const glm::ivec2& fragCoord) const;
+    void renderTile(const ViewParams& view, const glm::ivec2& origin, std::vector<glm::vec3>& pixels);
+};
+
+#endif
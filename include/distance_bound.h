@@ -0,0 +1,24 @@
+#ifndef DISTANCE_BOUND_H
+#define DISTANCE_BOUND_H
+
+#include "fractal.h"
+#include <glm/glm.hpp>
+
+// Precomputed lower bound on the object-space distance estimate, which
+// marchInterval() steps along through empty space before the exact march
+// takes over. Implemented by the dense DistanceVolume and the sparse BrickMap.
+class DistanceBound {
+public:
+    virtual ~DistanceBound() = default;
+
+    // True when the bound holds at params' iteration count.
+    virtual bool covers(const FractalParams& params) const = 0;
+    // Object-space step below which the exact estimate is cheaper; about one
+    // sample spacing.
+    virtual float minStep() const = 0;
+    // Lower bound on the object-space estimate at objPos. Points outside the
+    // bounding cube lose their distance to it.
+    virtual float lowerBound(const glm::vec3& objPos) const = 0;
+};
+
+#endif
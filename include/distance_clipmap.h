@@ -0,0 +1,82 @@
+#ifndef DISTANCE_CLIPMAP_H
+#define DISTANCE_CLIPMAP_H
+
+#include "distance_bound.h"
+#include "fractal.h"
+#include "thread_pool.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Distance field that follows the camera: LEVELS nested size^3 grids centred
+// on it, each with twice the sample spacing of the one inside it. The
+// coarsest is as wide as the bounding cube but centred on the camera too, so
+// unless the camera is at the cube's centre part of the cube lies outside
+// every level and gets no bound. Samples are addressed toroidally (grid
+// point g lives at g mod size), so when the camera moves only the newly
+// exposed slabs are evaluated, and update() spreads that work over frames.
+//
+// Like DistanceVolume, each sample is the smallest estimate over the whole
+// iteration counts up to iterations(), lowered by half a sample diagonal, and
+// a point reads its nearest sample in the finest level that has it.
+class DistanceClipmap : public DistanceBound {
+public:
+    static const int LEVELS = 4;
+
+    // size is the samples per side of every level, rounded up to even.
+    explicit DistanceClipmap(int size);
+
+    // Recentres the levels on centre (object space) and evaluates newly
+    // exposed samples, finest level first, until about budget have been
+    // taken; always at least one slab. A new iteration count discards
+    // everything. Returns the number of samples evaluated.
+    size_t update(const glm::vec3& centre, int iterations, size_t budget, ThreadPool& pool);
+
+    // True once every level holds its whole window.
+    bool complete() const;
+
+    int size() const { return side; }
+    int iterations() const { return count; }
+    float voxelSize(int level) const;
+
+    // size^3 floats, x fastest, grid point g at g mod size.
+    const float* levelData(int level) const { return levels[level].samples.data(); }
+    // Grid points, in units of voxelSize(level), whose samples are current.
+    // Empty when validMin == validMax.
+    glm::ivec3 validMin(int level) const { return levels[level].validMin; }
+    glm::ivec3 validMax(int level) const { return levels[level].validMax; }
+    // Changes whenever the level's samples or valid box do, for uploads.
+    uint64_t levelVersion(int level) const { return levels[level].version; }
+
+    bool covers(const FractalParams& params) const override {
+        return count >= 1 && params.maxIterations >= 1 && params.maxIterations <= count;
+    }
+    float minStep() const override { return voxelSize(0); }
+    // 0 where no level has a sample, and where the level's sample is within
+    // one of its own spacings of the surface, so coarse levels hand over to
+    // the exact march instead of crawling.
+    float lowerBound(const glm::vec3& objPos) const override;
+
+private:
+    struct Level {
+        glm::ivec3 origin = glm::ivec3(0);
+        glm::ivec3 validMin = glm::ivec3(0);
+        glm::ivec3 validMax = glm::ivec3(0);
+        // Face of the valid box the next slab grows, so it grows evenly.
+        int nextFace = 0;
+        uint64_t version = 0;
+        std::vector<float> samples;
+    };
+
+    int side;
+    int count = 0;
+    float baseVoxel;
+    Level levels[LEVELS];
+
+    size_t slot(const glm::ivec3& g) const;
+    void evaluate(Level& level, float voxel, const glm::ivec3& lo, const glm::ivec3& hi, ThreadPool& pool);
+    size_t growLevel(int index, size_t budget, bool force, ThreadPool& pool);
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef DISTANCE_VOLUME_H
+#define DISTANCE_VOLUME_H
+
+#include "distance_bound.h"
+#include "fractal.h"
+#include "thread_pool.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Coarse distance field of the fractal: resolution^3 samples of mandelboxDE
+// on a grid spanning the bounding cube, each lowered by the distance to the
+// farthest point that samples it. The march takes these as safe steps through
+// empty space before switching to the exact estimate (see marchInterval()).
+//
+// A bake is deterministic, so it is written once per parameter set to a cache
+// file and memory-mapped by every later session on the machine.
+//
+// A symmetric bake stores only the samples in the fundamental domain of the
+// Mandelbox's symmetries (see symmetryFold()), 1/48 of the grid, and folds
+// every lookup into it. Its resolution is odd so samples lie on the mirror
+// planes.
+class DistanceVolume : public DistanceBound {
+public:
+    DistanceVolume() = default;
+    ~DistanceVolume() override;
+
+    DistanceVolume(const DistanceVolume&) = delete;
+    DistanceVolume& operator=(const DistanceVolume&) = delete;
+
+    // Each sample is the smallest estimate over the whole iteration counts up
+    // to iterations, so it bounds every count iterationLod() can pick.
+    // symmetric rounds resolution up to odd.
+    void bake(int resolution, int iterations, ThreadPool& pool, bool symmetric = false);
+
+    bool save(const std::string& path) const;
+    // Maps a file written by save(); fails if it was baked with different
+    // Mandelbox constants or file version.
+    bool map(const std::string& path);
+
+    // Maps the cached bake for these settings from directory, baking and
+    // saving it first when there is none. An empty directory bakes without
+    // caching.
+    bool load(const std::string& directory, int resolution, int iterations, ThreadPool& pool,
+              bool symmetric = false);
+
+    // $FRACTAL_VOLUME_CACHE, else ~/.cache/fractal (or $XDG_CACHE_HOME/fractal).
+    static std::string defaultDirectory();
+    static std::string cacheFileName(int resolution, int iterations, bool symmetric = false);
+
+    bool empty() const { return samples == nullptr; }
+    int resolution() const { return size; }
+    int iterations() const { return count; }
+    bool symmetric() const { return folded; }
+    // Object-space spacing of the samples.
+    float cellSize() const;
+    // resolution^3 floats, x fastest; for a symmetric bake, sampleCount()
+    // floats of the samples at or above the centre with i >= j >= k, in the
+    // order of wedgeIndex().
+    const float* data() const { return samples; }
+    size_t sampleCount() const;
+    // Samples per axis from the centre of a symmetric bake to its face.
+    int halfResolution() const { return size / 2 + 1; }
+    // Position in data() of the sample i, j, k steps from the centre of a
+    // symmetric bake, for i >= j >= k >= 0.
+    static size_t wedgeIndex(int i, int j, int k);
+
+    bool covers(const FractalParams& params) const override {
+        return !empty() && params.maxIterations >= 1 && params.maxIterations <= count;
+    }
+    float minStep() const override { return cellSize(); }
+    float lowerBound(const glm::vec3& objPos) const override;
+
+private:
+    int size = 0;
+    int count = 0;
+    bool folded = false;
+    const float* samples = nullptr;
+    std::vector<float> baked;
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+
+    void release();
+};
+
+#endif
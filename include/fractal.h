@@ -0,0 +1,140 @@
+#ifndef FRACTAL_H
+#define FRACTAL_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// Host-side port of the distance estimator in shaders/fragment.glsl.
+// Every function here evaluates the same float operations in the same order
+// as the shader, so results match an IEEE-conformant GLSL implementation.
+
+const int MAX_STEPS = 80;
+// Hit floor and far limit in object space; the march multiplies them by
+// scale so it stops at the same place on the fractal at every zoom level.
+const float MIN_DIST = 0.001f;
+const float MAX_DIST = 100.0f;
+// Beyond the floor, a ray hits once the surface is within this fraction of
+// its pixel's footprint; further steps could not change the pixel.
+const float HIT_FOOTPRINT = 0.5f;
+// Refinement steps after an over-relaxed hit.
+const int BISECTION_STEPS = 4;
+
+const float MANDELBOX_SCALE = -1.5f;
+const float MANDELBOX_MIN_RADIUS = 0.5f;
+const float MANDELBOX_FIXED_RADIUS = 2.25f;
+// Squared escape radius of the fold loop. Past it z only grows and
+// length(z) / dr has settled to within a fraction of a percent.
+const float ESCAPE_RADIUS2 = 1.0e6f;
+// Object-space size of the detail the first fold iteration adds; each further
+// iteration adds detail |MANDELBOX_SCALE| times finer. See iterationLod().
+const float LOD_DETAIL = 1.0f;
+// Half-size of the object-space cube around the fractal. With a negative
+// scale the set lies in [-2, 2]^3 and the estimate outside that cube is never
+// below the distance to it, so a march may start where a ray enters it.
+const float BOUNDS_HALF_SIZE = 2.0f;
+
+// Mirrors the uniforms that fragment.glsl reads inside sceneSDF.
+struct FractalParams {
+    int maxIterations = 16;
+    float scale = 1.0f;
+    float time = 0.0f;
+    bool autoRotate = false;
+};
+
+// Per-frame camera state, the host equivalent of the shader's camera uniforms.
+// camPos is in world space, i.e. cameraMantissa * scale.
+struct ViewParams {
+    glm::vec3 camPos = glm::vec3(0.0f, 0.0f, 5.0f);
+    glm::vec3 camFront = glm::vec3(0.0f, 0.0f, -1.0f);
+    glm::vec3 camRight = glm::vec3(1.0f, 0.0f, 0.0f);
+    glm::vec3 camUp = glm::vec3(0.0f, 1.0f, 0.0f);
+    float fov = 0.7853982f;
+    int width = 960;
+    int height = 540;
+    FractalParams fractal;
+};
+
+struct MarchResult {
+    float depth;
+    int steps;
+    bool hit;
+    float orbitTrap;
+    // Distance estimates taken, including rejected steps and refinement.
+    int evaluations;
+};
+
+class DistanceBound;
+
+// How a primary ray is marched, beyond the scene itself.
+struct MarchSettings {
+    // Angle covered by one pixel (see pixelCone()); 0 leaves only the
+    // MIN_DIST floor as hit epsilon.
+    float pixelCone = 0.0f;
+    // Over-relaxed sphere tracing when above 1: each step covers relaxation
+    // times the distance estimate while consecutive spheres overlap. 1 or
+    // less is the plain tracer.
+    float relaxation = 1.0f;
+    // Baked distance field (DistanceVolume or BrickMap) to skip empty space
+    // with; ignored when null or when it does not cover the iteration count.
+    const DistanceBound* volume = nullptr;
+};
+
+// iterations may be fractional: the estimate and orbit trap then blend between
+// the whole counts either side, so both stay continuous as the count changes.
+float mandelboxDE(const glm::vec3& pos, float iterations, float& orbitTrap);
+// Smallest mandelboxDE(pos, n) over the whole counts n in [1, maxIterations],
+// in one pass.
+float mandelboxDEMin(const glm::vec3& pos, int maxIterations);
+float sceneSDF(const glm::vec3& p, const FractalParams& params, float& orbitTrap);
+float sceneSDF(const glm::vec3& p, const FractalParams& params, float iterations, float& orbitTrap);
+// startDepth and startTrap resume a march the way the shader's depth prepass
+// does: the ray starts no nearer than startDepth, with the orbit trap
+// gathered before it.
+MarchResult rayMarch(const glm::vec3& ro, const glm::vec3& rd, const FractalParams& params,
+                     const MarchSettings& settings = MarchSettings(),
+                     float startDepth = 0.0f, float startTrap = 1000.0f);
+
+// Hit epsilon at a depth along a ray, and the depth a miss gives up at.
+float hitEpsilon(float depth, float pixelCone, const FractalParams& params);
+float farLimit(const FractalParams& params);
+
+// World-space depths at which a ray enters and leaves the bounding cube,
+// grown by the largest hit epsilon before farLimit() so grazing rays still
+// hit. Returns false when the ray misses it. entry is at least 0.
+bool boundsInterval(const glm::vec3& ro, const glm::vec3& rd, const FractalParams& params,
+                    float pixelCone, float& entry, float& exit);
+
+// Depth a primary ray starts marching at and the depth past which it cannot
+// hit: the bounding cube interval, with the start moved past the empty space
+// settings.volume proves and then to at least startDepth. Returns
+// false when the ray cannot hit at all.
+bool marchInterval(const glm::vec3& ro, const glm::vec3& rd, const FractalParams& params,
+                   const MarchSettings& settings, float startDepth, float& start, float& limit);
+
+// Fold iterations needed to resolve detail down to a hit epsilon, at most
+// maxIterations.
+float iterationLod(float epsilon, const FractalParams& params);
+
+// Ray direction for a fragment with the given TexCoord, as computed in main().
+glm::vec3 primaryRayDir(const ViewParams& view, const glm::vec2& texCoord);
+
+// Angle between the rays of two vertically adjacent pixels at the centre of
+// the screen.
+float pixelCone(const ViewParams& view);
+
+glm::vec3 toObjectSpace(const glm::vec3& p, const FractalParams& params);
+
+// The Mandelbox is unchanged by flipping the sign of an axis or permuting the
+// axes, so the estimate at p is the one at symmetryFold(p): |p| sorted so
+// x >= y >= z, inside 1/48 of the space. Permuting changes the summation
+// order in the folds, so the two agree only to the last few bits.
+glm::vec3 symmetryFold(const glm::vec3& p);
+
+// Batch variants: distances and orbitTraps must hold count entries,
+// orbitTraps may be null when the trap is not needed.
+void mandelboxDEBatch(const glm::vec3* points, size_t count, int maxIterations,
+                      float* distances, float* orbitTraps);
+void sceneSDFBatch(const glm::vec3* points, size_t count, const FractalParams& params,
+                   float* distances, float* orbitTraps);
+
+#endif
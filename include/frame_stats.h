@@ -0,0 +1,120 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct FrameTimeSummary {
+    size_t count = 0;
+    double minMs = 0.0;
+    double meanMs = 0.0;
+    double p50Ms = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+    double fps = 0.0;
+};
+
+// Order statistics use the nearest-rank method; fps is frames / total time.
+FrameTimeSummary summarizeFrameTimes(std::vector<double> frameMs);
+
+// One frame as seen by the render loop. GPU timings arrive a few frames late,
+// so a sample carries the GPU result that became available this frame and the
+// number of the frame it belongs to; the recorder files it under that frame.
+// A sample with frame < 0 only delivers a late GPU result.
+struct FrameSample {
+    long long frame = 0;
+    double frameMs = 0.0;
+    double cpuMs = 0.0;
+    double swapMs = 0.0;
+    long long gpuFrame = -1;
+    double gpuMs = -1.0;
+
+    glm::vec3 mantissa = glm::vec3(0.0f);
+    int exponent = 0;
+    int maxIterations = 0;
+    float time = 0.0f;
+    float speed = 0.0f;
+    // Fraction of the window resolution the frame was rendered at.
+    float renderScale = 1.0f;
+};
+
+// Single-producer single-consumer ring; push and pop never block or allocate.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacityPow2) : items(capacityPow2), mask(capacityPow2 - 1) {}
+
+    bool push(const T& item) {
+        size_t head = writeIndex.load(std::memory_order_relaxed);
+        if (head - readIndex.load(std::memory_order_acquire) == items.size())
+            return false;
+        items[head & mask] = item;
+        writeIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        size_t tail = readIndex.load(std::memory_order_relaxed);
+        if (tail == writeIndex.load(std::memory_order_acquire))
+            return false;
+        item = items[tail & mask];
+        readIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> items;
+    size_t mask;
+    alignas(64) std::atomic<size_t> writeIndex{0};
+    alignas(64) std::atomic<size_t> readIndex{0};
+};
+
+// Collects FrameSamples from the render thread through a lock-free ring and
+// keeps the full history on a background thread, which also prints rolling
+// percentiles and stutter counts every reportInterval seconds (0 = silent).
+// A stutter is a frame taking more than twice the median of its window.
+class FrameStatsRecorder {
+public:
+    explicit FrameStatsRecorder(double reportInterval = 1.0);
+    ~FrameStatsRecorder();
+
+    FrameStatsRecorder(const FrameStatsRecorder&) = delete;
+    FrameStatsRecorder& operator=(const FrameStatsRecorder&) = delete;
+
+    // Render thread only. Never blocks; if the reporter falls behind the
+    // sample is dropped and counted.
+    void record(const FrameSample& sample);
+
+    // Stops the reporter after draining the ring. Called by the destructor.
+    void stop();
+
+    // Writes every recorded frame after stop(): JSON when the path ends in
+    // .json, CSV otherwise.
+    bool dump(const std::string& filePath) const;
+
+private:
+    SpscRing<FrameSample> ring{4096};
+    std::atomic<size_t> dropped{0};
+
+    double interval;
+    std::vector<FrameSample> history;
+    size_t windowStart = 0;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread reporter;
+
+    void run();
+    void drain();
+    void report();
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+// GPU-side frame and stage timing. Each frame brackets itself with
+// GL_TIMESTAMP queries and each stage with a GL_TIME_ELAPSED query. Queries
+// live in a ring Latency frames deep and are only read once the driver says
+// they are available, so timing never stalls the pipeline; results describe
+// the frame Latency frames ago.
+class GpuTimer {
+public:
+    explicit GpuTimer(int latency = 4);
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    // Stages must be registered before the first beginFrame.
+    int addStage(const std::string& name);
+    const std::string& stageName(int stage) const { return stages[stage]; }
+    int stageCount() const { return static_cast<int>(stages.size()); }
+
+    // Returns true when the results of an earlier frame were collected.
+    bool beginFrame();
+    void endFrame();
+
+    // Stage queries cannot nest: end one stage before beginning the next.
+    void beginStage(int stage);
+    void endStage(int stage);
+
+    // Latest collected results in milliseconds, -1 when none yet, and the
+    // number of the frame they belong to (counting beginFrame calls from 0).
+    double frameMs() const { return lastFrameMs; }
+    double stageMs(int stage) const { return lastStageMs[stage]; }
+    long long resultFrame() const { return lastFrameNumber; }
+
+private:
+    struct Slot {
+        GLuint frameStart = 0;
+        GLuint frameEnd = 0;
+        std::vector<GLuint> stageQueries;
+        std::vector<bool> stageIssued;
+        bool issued = false;
+        long long frameNumber = -1;
+    };
+
+    std::vector<std::string> stages;
+    std::vector<Slot> slots;
+    int current = -1;
+    long long frameCounter = 0;
+    long long lastFrameNumber = -1;
+    double lastFrameMs = -1.0;
+    std::vector<double> lastStageMs;
+
+    void createQueries();
+    bool collect(Slot& slot);
+};
+
+#endif
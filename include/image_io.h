@@ -0,0 +1,19 @@
+#ifndef IMAGE_IO_H
+#define IMAGE_IO_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Writes width * height colours, top row first. The format follows the file
+// extension: .pfm stores raw floats, anything else is written as binary PPM
+// with values clamped to [0, 1].
+bool writeImage(const std::string& filePath, int width, int height,
+                const std::vector<glm::vec3>& pixels);
+
+bool writePPM(const std::string& filePath, int width, int height,
+              const std::vector<glm::vec3>& pixels);
+bool writePFM(const std::string& filePath, int width, int height,
+              const std::vector<glm::vec3>& pixels);
+
+#endif
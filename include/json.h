@@ -0,0 +1,39 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal JSON document model for job and keyframe files.
+class JsonValue {
+public:
+    enum Type {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    Type type = Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    bool isNumber() const { return type == Number; }
+    bool isString() const { return type == String; }
+    bool isArray() const { return type == Array; }
+    bool isObject() const { return type == Object; }
+
+    // Member lookup; null when this is not an object or the key is missing.
+    const JsonValue* find(const std::string& key) const;
+};
+
+bool parseJson(const std::string& text, JsonValue& out, std::string& error);
+bool readJsonFile(const char* filePath, JsonValue& out, std::string& error);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef OFFSCREEN_CONTEXT_H
+#define OFFSCREEN_CONTEXT_H
+
+// Display-less OpenGL core context created through EGL. Uses the Mesa
+// surfaceless platform when available, so it works on servers without X or
+// a GPU (Mesa llvmpipe). Rendering must go to an FBO; there is no default
+// framebuffer.
+class OffscreenContext {
+public:
+    OffscreenContext() = default;
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    // Creates the context and makes it current on the calling thread.
+    bool create(int major = 4, int minor = 1);
+    bool makeCurrent();
+
+    // Renderer string of the current context, for logs.
+    const char* renderer() const;
+
+    // Loader for gladLoadGLLoader.
+    static void* getProcAddress(const char* name);
+
+private:
+    void* display = nullptr;
+    void* context = nullptr;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef PACKET_MARCH_H
+#define PACKET_MARCH_H
+
+#include "fractal.h"
+#include <cstdint>
+#include <vector>
+
+// Structure-of-arrays ray storage for the SIMD marcher.
+// startDepth and startTrap are rayMarch()'s arguments of the same names.
+struct RayBatch {
+    std::vector<float> ox, oy, oz;
+    std::vector<float> dx, dy, dz;
+    std::vector<float> startDepth, startTrap;
+
+    void resize(size_t count);
+    size_t size() const { return ox.size(); }
+    void set(size_t i, const glm::vec3& origin, const glm::vec3& dir,
+             float start = 0.0f, float trap = 1000.0f);
+};
+
+struct MarchBatch {
+    std::vector<float> depth;
+    std::vector<int> steps;
+    std::vector<int> evaluations;
+    std::vector<uint8_t> hit;
+    std::vector<float> orbitTrap;
+
+    void resize(size_t count);
+    size_t size() const { return depth.size(); }
+};
+
+enum class SimdLevel {
+    Scalar,
+    SSE42,
+    AVX2,
+    AVX512
+};
+
+SimdLevel detectSimdLevel();
+const char* simdLevelName(SimdLevel level);
+
+// The level used by marchRays. Defaults to detectSimdLevel() on first use;
+// requesting a level the CPU does not support falls back to the best one it does.
+SimdLevel activeSimdLevel();
+void setSimdLevel(SimdLevel level);
+
+// Marches every ray in the batch with the same semantics as rayMarch(),
+// 4/8/16 lanes at a time depending on the active level.
+void marchRays(const RayBatch& rays, const FractalParams& params, MarchBatch& out,
+               const MarchSettings& settings = MarchSettings());
+
+#endif
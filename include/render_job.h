@@ -0,0 +1,35 @@
+#ifndef RENDER_JOB_H
+#define RENDER_JOB_H
+
+#include "fractal.h"
+#include "json.h"
+#include <string>
+#include <vector>
+
+// One still for fractal_render. Fields mirror the interactive state in main.cpp.
+struct FrameJob {
+    glm::vec3 mantissa = glm::vec3(0.0f, 0.0f, 5.0f);
+    int exponent = -2;
+    float yaw = -90.0f;
+    float pitch = 0.0f;
+    float fov = 45.0f;
+    int width = 960;
+    int height = 540;
+    int maxIterations = 16;
+    float time = 0.0f;
+    bool autoRotate = false;
+    std::string output = "fractal.ppm";
+};
+
+ViewParams makeViewParams(const FrameJob& job);
+
+// Overrides the fields of job that appear as members of object.
+bool applyJobJson(const JsonValue& object, FrameJob& job, std::string& error);
+
+// Reads a job file. Top-level members are defaults for every entry of the
+// optional "frames" array; without one the file describes a single frame.
+// Frames without an explicit output get base's output with a frame number.
+bool loadJobFile(const char* filePath, const FrameJob& base,
+                 std::vector<FrameJob>& frames, std::string& error);
+
+#endif
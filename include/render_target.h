@@ -0,0 +1,40 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Framebuffer object with a colour texture attachment and an optional second
+// one for auxiliary per-pixel output.
+class RenderTarget {
+public:
+    GLuint FBO = 0;
+    GLuint Texture = 0;
+    GLuint ExtraTexture = 0;
+    int Width = 0;
+    int Height = 0;
+
+    RenderTarget() = default;
+    ~RenderTarget();
+
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    // (Re)allocates the attachments; a no-op when size and formats are
+    // unchanged. extraFormat adds colour attachment 1.
+    bool resize(int width, int height, GLenum internalFormat = GL_RGBA32F, GLenum extraFormat = GL_NONE);
+
+    void bind() const;
+
+    // Reads the colour attachment back as width * height colours, top row first.
+    void readPixels(std::vector<glm::vec3>& pixels) const;
+
+private:
+    GLenum format = 0;
+    GLenum extraFormat = GL_NONE;
+
+    void release();
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef RESOLUTION_CONTROLLER_H
+#define RESOLUTION_CONTROLLER_H
+
+// Chooses the render scale (fraction of the window size per axis) that keeps
+// the GPU time of a frame near a target. Assumes the time is proportional to
+// the number of pixels, which holds for the ray marcher.
+class ResolutionController {
+public:
+    double TargetMs = 16.0;
+    float MinScale = 0.35f;
+    float MaxScale = 1.0f;
+    // Fraction of the distance to the ideal scale covered per measurement;
+    // lower is smoother but slower to react.
+    float Response = 0.3f;
+
+    float scale() const { return current; }
+
+    // Feeds the GPU time of a frame that was rendered at measuredScale.
+    // Measurements arrive a few frames late, hence the explicit scale.
+    void update(double measuredMs, float measuredScale);
+
+private:
+    float current = 1.0f;
+};
+
+#endif
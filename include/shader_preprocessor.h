@@ -0,0 +1,19 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <map>
+#include <string>
+
+// Name -> value; an ordered map so equal sets compare and hash the same.
+using ShaderDefines = std::map<std::string, std::string>;
+
+// Loads a GLSL file, expanding #include "file" relative to the including
+// file, and inserts a #define for each entry right after the #version line.
+// #line directives keep compiler messages pointing at the original files.
+bool preprocessShader(const std::string& path, const ShaderDefines& defines,
+                      std::string& source, std::string& error);
+
+// Readable form of a define set for logs, e.g. "AUTO_ROTATE=0 MAX_ITERATIONS=16".
+std::string describeDefines(const ShaderDefines& defines);
+
+#endif
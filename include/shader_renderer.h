@@ -0,0 +1,192 @@
+#ifndef SHADER_RENDERER_H
+#define SHADER_RENDERER_H
+
+#include "brick_map.h"
+#include "distance_clipmap.h"
+#include "distance_volume.h"
+#include "fractal.h"
+#include "render_target.h"
+#include "shader_variants.h"
+#include "uniform_ring.h"
+#include <memory>
+
+// Host copy of the FrameUniforms block in fragment.glsl (std140).
+struct FrameUniforms {
+    glm::vec3 camPos;
+    float fov;
+    glm::vec3 camFront;
+    float time;
+    glm::vec3 camRight;
+    float scale;
+    glm::vec3 camUp;
+    int maxIterations;
+    glm::vec3 resolution;
+    int autoRotate;
+};
+
+// Draws shaders/fragment.glsl as a full-screen quad into whatever framebuffer
+// is bound. Shared by the GLFW viewer and the offscreen GL backend.
+class ShaderRenderer {
+public:
+    // Draw with a variant that has the view's iteration count and rotation
+    // baked in once it has compiled; the generic variant covers the gap.
+    bool SpecializeVariants = true;
+
+    // Side in pixels of the blocks that share one cone in the depth prepass
+    // (shaders/depth_prepass.glsl); 0 marches every pixel from the camera.
+    int PrepassTile = 8;
+
+    // Start each pixel at this fraction of last frame's hit depth reprojected
+    // into the current view (shaders/reproject_*.glsl), e.g. 0.9; 0 turns it
+    // off. The frame is then drawn into an internal target and blitted out.
+    // Off by default: behind the depth prepass it saves few steps, and on
+    // software rasterisers the point scatter costs more than it saves.
+    float TemporalFraction = 0.0f;
+
+    // While consecutive draws show the same image, add one jittered sample
+    // per draw to a float running mean, up to this many, then only resolve
+    // it (shaders/accumulate_resolve.glsl). 0 draws one centred sample per
+    // frame. Temporal reprojection is skipped while accumulating.
+    int AccumulationSamples = 0;
+
+    // Over-relaxation factor of the fractal pass's sphere tracer (the
+    // relaxation uniform in fragment.glsl); 1 is the plain tracer.
+    float Relaxation = 1.0f;
+
+    // With asyncCompile set, variants link in the background and draw()
+    // shows a flat placeholder until the generic one is ready.
+    ShaderRenderer(const char* vertexPath = SHADER_PATH "vertex.glsl",
+                   const char* fragmentPath = SHADER_PATH "fragment.glsl",
+                   bool asyncCompile = false);
+    ~ShaderRenderer();
+
+    ShaderRenderer(const ShaderRenderer&) = delete;
+    ShaderRenderer& operator=(const ShaderRenderer&) = delete;
+
+    void draw(const ViewParams& view);
+
+    // Uploads a baked distance volume as a 3D texture; the fractal pass then
+    // skips empty space with it while it covers the view's iteration count.
+    void setDistanceVolume(const DistanceVolume& volume);
+    // The same with a brick map, uploaded as an index texture plus a brick
+    // atlas. Replaces a distance volume and vice versa. A map whose textures
+    // exceed GL_MAX_3D_TEXTURE_SIZE is refused with an error and skipping
+    // turns off.
+    void setBrickMap(const BrickMap& bricks);
+    // The same with a camera-centred clipmap; call again after every
+    // DistanceClipmap::update() to send the levels that changed.
+    void setClipmap(const DistanceClipmap& clipmap);
+
+    // True once draw() renders the fractal rather than the placeholder.
+    bool ready();
+    // Blocks until the program draw(view) would pick is linked.
+    void waitUntilReady(const ViewParams& view);
+
+    // Rebuilds the programs from the shader files. The current ones keep
+    // drawing until the new generic variant has linked, and stay in place if
+    // it fails.
+    void reload();
+    // True from reload() until draw() has swapped in or rejected the result.
+    bool reloadPending() const { return reloading != nullptr; }
+
+    // Samples in the current accumulated image; 0 when not accumulating.
+    int accumulatedSamples() const { return accumulated; }
+
+    // Define set of the variant specialised for a view.
+    static ShaderDefines variantDefines(const ViewParams& view);
+
+    // True when two views render the same picture.
+    static bool sameImage(const ViewParams& a, const ViewParams& b);
+
+private:
+    // Per-program uniform state; the handles are only used when the program
+    // does not declare the FrameUniforms block.
+    struct FrameBindings {
+        bool UsesBlock = false;
+        Uniform<glm::vec3> camPos, camFront, camRight, camUp, resolution;
+        Uniform<float> fov, time, scale;
+        Uniform<int> maxIterations;
+        Uniform<bool> autoRotate;
+        Uniform<int> prepassTile;
+        Uniform<int> prepassDepth;
+        Uniform<int> reprojectedDepth;
+        Uniform<float> temporalFraction;
+        Uniform<float> relaxation;
+        Uniform<int> previousDepth;
+        Uniform<glm::vec3> previousCamPos, previousCamFront, previousCamRight, previousCamUp;
+        Uniform<float> previousFov, previousScale, previousTime;
+        Uniform<glm::vec2> jitter;
+        Uniform<bool> linearOutput;
+        Uniform<int> accumulation;
+        Uniform<int> skipVolume;
+        Uniform<bool> skipSymmetric;
+        Uniform<int> distanceVolume;
+        Uniform<float> volumeCell;
+        Uniform<int> brickIndex;
+        Uniform<int> brickAtlas;
+        Uniform<int> clipmapLevels;
+        Uniform<int> clipmapBoxes;
+    };
+
+    struct ProgramSet {
+        std::unique_ptr<ShaderVariants> Fractal;
+        std::unique_ptr<ShaderVariants> Prepass;
+        std::unique_ptr<ShaderVariants> Reproject;
+        std::unique_ptr<ShaderVariants> Resolve;
+    };
+
+    std::string vertexPath;
+    std::string fragmentPath;
+    bool asyncCompile;
+    std::unique_ptr<ProgramSet> programs;
+    std::unique_ptr<ProgramSet> reloading;
+    RenderTarget prepassTarget;
+
+    // Colour plus hit depth; the frame alternates between the two so the
+    // previous one can be reprojected.
+    RenderTarget sceneTargets[2];
+    int sceneIndex = 0;
+    RenderTarget reprojectTarget;
+    ViewParams previousView;
+    bool hasHistory = false;
+
+    RenderTarget accumulationTarget;
+    ViewParams accumulatedView;
+    int accumulated = 0;
+
+    // The skipVolume uniform's value and the iteration count it covers.
+    int skipVolume = 0;
+    int skipIterations = 0;
+    bool skipSymmetric = false;
+    GLuint volumeTexture = 0;
+    float volumeCell = 0.0f;
+    GLuint brickIndexTexture = 0;
+    GLuint brickAtlasTexture = 0;
+    GLuint clipmapTexture = 0;
+    GLuint clipmapBoxTexture = 0;
+    int clipmapSize = 0;
+    // DistanceClipmap::levelVersion() of each level as last uploaded.
+    uint64_t clipmapVersions[DistanceClipmap::LEVELS] = {};
+
+    GLuint quadVAO = 0;
+    GLuint quadVBO = 0;
+    std::unique_ptr<Shader> placeholder;
+    std::map<const Shader*, FrameBindings> bindings;
+
+    std::unique_ptr<UniformRing> frameRing;
+    FrameUniforms lastFrame{};
+    bool frameWritten = false;
+
+    std::unique_ptr<ProgramSet> makePrograms();
+    Shader& generic();
+    Shader* selectVariant(ShaderVariants& variants, const ViewParams& view);
+    void finishReload();
+    bool historyUsable(const ViewParams& view) const;
+    bool runPrepass(Shader& prepass, const ViewParams& view);
+    bool runReprojection(Shader& reproject, const ViewParams& view);
+    void resolveAccumulation(Shader& resolve, GLint target, const ViewParams& view);
+    FrameBindings& bindingsFor(const Shader& program);
+    void setUniforms(FrameBindings& frame, const ViewParams& view);
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "Shader.h"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+
+// Programs built from one vertex/fragment pair under different define sets.
+// Each variant is compiled the first time it is asked for and kept until
+// Capacity others have been asked for since; the binary cache is keyed by the
+// expanded source, so an evicted variant comes back without a compile.
+class ShaderVariants {
+public:
+    // Variants kept besides the one without defines, which is never evicted.
+    size_t Capacity = 8;
+    // Called with a variant just before it is destroyed, so anything keyed
+    // by it can be dropped.
+    std::function<void(const Shader&)> OnEvict;
+
+    ShaderVariants(const char* vertexPath, const char* fragmentPath, bool async);
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    // Returns the variant for defines, starting its compile if needed. The
+    // reference stays valid until Capacity other variants have been asked for.
+    Shader& get(const ShaderDefines& defines);
+
+    size_t size() const { return programs.size(); }
+
+private:
+    struct Variant {
+        std::unique_ptr<Shader> program;
+        uint64_t lastUse = 0;
+    };
+
+    std::string vertexPath;
+    std::string fragmentPath;
+    bool async;
+    uint64_t uses = 0;
+    std::map<ShaderDefines, Variant> programs;
+
+    void evictLeastRecent();
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+
+// Reports edits to the files in a directory, for shader hot reload. Uses
+// inotify on Linux and polls modification times elsewhere. Changes are
+// debounced so an editor saving in several steps triggers one reload.
+class ShaderWatcher {
+public:
+    explicit ShaderWatcher(const std::string& directory);
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    // Never blocks; true once after a burst of changes has settled.
+    bool poll();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::string directory;
+    int inotifyFd = -1;
+    std::map<std::string, std::filesystem::file_time_type> modified;
+    Clock::time_point lastScan;
+    Clock::time_point lastChange;
+    bool pending = false;
+
+    bool readEvents();
+    bool scanModified();
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef SHADING_H
+#define SHADING_H
+
+#include "fractal.h"
+
+// Host port of the shading half of shaders/fragment.glsl: everything main()
+// does after rayMarch returns.
+
+// eps is the central-difference offset, the hit epsilon at the hit depth;
+// the estimates use the iteration count the march used there.
+glm::vec3 calcNormal(const glm::vec3& p, float eps, const FractalParams& params);
+float calcSoftShadow(const glm::vec3& ro, const glm::vec3& rd, float mint, float maxt,
+                     const FractalParams& params);
+float calcAO(const glm::vec3& p, const glm::vec3& n, const FractalParams& params);
+glm::vec3 getColor(const glm::vec3& p, const glm::vec3& normal, float orbitTrap);
+glm::vec3 calculateLighting(const glm::vec3& p, const glm::vec3& normal, const glm::vec3& rd,
+                            float ao, const FractalParams& params);
+glm::vec3 skyColor(const glm::vec3& rd);
+
+// Final gamma-corrected colour for a primary ray, as written to FragColor.
+glm::vec3 shadePixel(const glm::vec3& ro, const glm::vec3& rd, const MarchResult& march,
+                     const FractalParams& params, float pixelCone);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool. parallelFor deals the index range out to the workers in
+// contiguous runs, so neighbouring items stay on one core; a worker that runs
+// dry steals from the far end of another worker's run.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    // Calls fn(i) for every i in [0, count) and blocks until all have returned.
+    // Not reentrant: fn must not call parallelFor on the same pool.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+    // Each task carries its job so a worker still draining one parallelFor
+    // can never run an index of the next one against the wrong function.
+    struct Task {
+        const std::function<void(size_t)>* fn;
+        size_t index;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> items;
+    };
+
+    void workerLoop(unsigned index);
+    bool popOrSteal(unsigned index, Task& task);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    size_t generation = 0;
+    std::atomic<size_t> remaining{0};
+    bool stopping = false;
+};
+
+#endif
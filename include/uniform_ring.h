@@ -0,0 +1,37 @@
+#ifndef UNIFORM_RING_H
+#define UNIFORM_RING_H
+
+#include <glad/glad.h>
+#include <vector>
+
+// Storage for a std140 uniform block that changes every frame. On GL 4.4+ it
+// is a persistently mapped buffer split into Slots regions, each guarded by a
+// fence, so writing the next frame never waits on the GPU reading the last.
+// Older contexts fall back to glBufferSubData on a single region.
+class UniformRing {
+public:
+    UniformRing(GLsizeiptr blockSize, GLuint binding, int slots = 3);
+    ~UniformRing();
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    // Copies blockSize bytes into the next free region and binds it.
+    void write(const void* data);
+
+    // Fences the bound region; call after the draws that read it.
+    void fence();
+
+    bool persistent() const { return mapped != nullptr; }
+
+private:
+    GLuint buffer = 0;
+    GLuint binding;
+    GLsizeiptr size;
+    GLsizeiptr stride;
+    int slot = 0;
+    char* mapped = nullptr;
+    std::vector<GLsync> fences;
+};
+
+#endif
@@ -0,0 +1,12 @@
+#version 410 core
+
+in vec2 TexCoord;
+out vec4 FragColor;
+
+// Running mean of the jittered samples in linear colour.
+uniform sampler2D accumulation;
+
+void main() {
+    vec3 color = texelFetch(accumulation, ivec2(gl_FragCoord.xy), 0).rgb;
+    FragColor = vec4(pow(color, vec3(1.0 / 2.2)), 1.0);
+}
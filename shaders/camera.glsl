@@ -0,0 +1,16 @@
+// Primary ray through a point on the screen, texCoord in [0, 1], for a
+// camera basis and vertical field of view.
+vec3 cameraRay(vec3 front, vec3 right, vec3 up, float fieldOfView, vec2 texCoord) {
+    float tanHalfFov = tan(fieldOfView / 2.0);
+    vec2 uv = (texCoord * 2.0 - 1.0) * vec2(resolution.x / resolution.y, 1.0);
+
+    return normalize(
+        front + 
+        right * uv.x * tanHalfFov +
+        up * uv.y * tanHalfFov
+    );
+}
+
+vec3 cameraRay(vec2 texCoord) {
+    return cameraRay(camFront, camRight, camUp, fov, texCoord);
+}
@@ -0,0 +1,55 @@
+#version 410 core
+
+// Marches one cone per prepassTile x prepassTile block of full-resolution
+// pixels and writes how far every ray in the block can skip without
+// crossing the surface, plus the orbit trap gathered on the way so colouring
+// still sees the skipped part of the ray. Rendered at the block resolution
+// into an RG32F target.
+
+out vec2 StartDepth;
+
+#include "frame_uniforms.glsl"
+#include "scene.glsl"
+#include "camera.glsl"
+
+uniform int prepassTile;
+
+void main() {
+    vec2 blockMin = floor(gl_FragCoord.xy) * float(prepassTile);
+    vec2 blockMax = min(blockMin + float(prepassTile), resolution.xy);
+
+    vec3 axis = cameraRay((blockMin + blockMax) * 0.5 / resolution.xy);
+
+    // A ray through the block is within depth * spread of the axis point at
+    // the same depth; the widest rays pass through the block's corners.
+    float spread = length(cameraRay(blockMin / resolution.xy) - axis);
+    spread = max(spread, length(cameraRay(vec2(blockMax.x, blockMin.y) / resolution.xy) - axis));
+    spread = max(spread, length(cameraRay(vec2(blockMin.x, blockMax.y) / resolution.xy) - axis));
+    spread = max(spread, length(cameraRay(blockMax / resolution.xy) - axis));
+
+    float minDist = MIN_DIST * scale;
+    float maxDist = farLimit();
+    float depth = 0.0;
+    float orbitTrap = 1000.0;
+    for (int i = 0; i < MAX_STEPS; i++) {
+        // The sphere of radius dist around the axis point is empty, and it
+        // still contains every ray of the cone for the next step.
+        // The pixels' own march uses this iteration count at this depth.
+        float trap;
+        float iterations = iterationLod(hitEpsilon(depth, pixelCone()));
+        float step = sceneSDF(camPos + axis * depth, iterations, trap) - depth * spread;
+        if (step < minDist) {
+            break;
+        }
+
+        orbitTrap = min(orbitTrap, trap);
+
+        depth += step;
+
+        if (depth >= maxDist) {
+            break;
+        }
+    }
+
+    StartDepth = vec2(min(depth, maxDist), orbitTrap);
+}
@@ -1,116 +1,244 @@
 #version 410 core
 
 in vec2 TexCoord;
-out vec4 FragColor;
-
-uniform vec3 camPos;
-uniform vec3 camFront;
-uniform vec3 camRight;
-uniform vec3 camUp;
-uniform float fov;
-uniform float time;
-uniform vec3 resolution;
-uniform float scale;
-uniform float adaptiveSpeed;
+layout(location = 0) out vec4 FragColor;
+// Hit depth (farLimit() on a miss) and orbit trap, kept for the next frame's
+// reprojection.
+layout(location = 1) out vec2 HitDepth;
 
-uniform int maxIterations;
-uniform bool autoRotate;
+#include "frame_uniforms.glsl"
 
-const int MAX_STEPS = 80;
-const float MIN_DIST = 0.001;
-const float MAX_DIST = 100.0;
+uniform float adaptiveSpeed;
 
-float mandelboxDE(vec3 pos, out float orbitTrap) {
-    vec3 z = pos;
-    float dr = 1.0;
+#include "scene.glsl"
+#include "camera.glsl"
+
+// Start depth and orbit trap from depth_prepass.glsl, one per prepassTile
+// block; 0 disables.
+uniform sampler2D prepassDepth;
+uniform int prepassTile;
+
+// Last frame's depth and trap moved into this view by reproject_*.glsl.
+// Pixels nothing landed on hold REPROJECT_EMPTY.
+uniform sampler2D reprojectedDepth;
+uniform float temporalFraction;
+const float REPROJECT_EMPTY = 1e9;
+
+// Sub-pixel offset of the ray in pixels, for progressive accumulation. With
+// linearOutput set the colour is left for accumulate_resolve.glsl to
+// gamma-correct once the samples are averaged.
+uniform vec2 jitter;
+uniform bool linearOutput;
+
+// Over-relaxed sphere tracing when above 1 (Keinert et al., "Enhanced Sphere
+// Tracing"): steps cover relaxation times the distance estimate while the
+// spheres of consecutive points overlap. When they do not, the ray goes back,
+// takes the plain step and stays unrelaxed; a relaxed hit is refined by
+// bisection. 1 or less (or unset) is the plain tracer. Mirrored by rayMarch()
+// in src/fractal.cpp.
+uniform float relaxation;
+const int BISECTION_STEPS = 4;
+
+// Baked lower bounds on the estimate to skip empty space with (see
+// include/distance_bound.h): 0 none, 1 DistanceVolume, 2 BrickMap,
+// 3 DistanceClipmap.
+uniform int skipVolume;
+// The volume or brick map holds the octant at and above the centre, and
+// lookups fold into it with symmetryFold().
+uniform bool skipSymmetric;
+
+// DistanceVolume: each texel bounds the estimate anywhere it is the nearest
+// sample to. volumeCell is the object-space sample spacing.
+uniform sampler3D distanceVolume;
+uniform float volumeCell;
+
+// BrickMap: brickIndex holds the bound of each cell and the index of its
+// brick or -1; brickAtlas packs the 8-bit bricks side by side.
+uniform sampler3D brickIndex;
+uniform sampler3D brickAtlas;
+const int BRICK_SIZE = 8;
+
+// DistanceClipmap: clipmapLevels stacks the toroidal levels along z, finest
+// first. Texel (0, l) of clipmapBoxes holds level l's valid box minimum and
+// its sample spacing in w, texel (1, l) the box maximum.
+uniform sampler3D clipmapLevels;
+uniform sampler2D clipmapBoxes;
+
+// Mirrors symmetryFold() in src/fractal.cpp: |p| sorted so x >= y >= z.
+vec3 symmetryFold(vec3 p) {
+    p = abs(p);
+    if (p.x < p.y) {
+        p.xy = p.yx;
+    }
+    if (p.y < p.z) {
+        p.yz = p.zy;
+    }
+    if (p.x < p.y) {
+        p.xy = p.yx;
+    }
+    return p;
+}
 
-    const float scale = -1.5;
-    const float minRadius = 0.5;
-    const float fixedRadius = 2.25;
+// Mirrors DistanceVolume::lowerBound().
+float volumeBound(vec3 objPos) {
+    vec3 q = clamp(objPos, -BOUNDS_HALF_SIZE, BOUNDS_HALF_SIZE);
+    ivec3 size = textureSize(distanceVolume, 0);
+    vec3 g = skipSymmetric ? symmetryFold(q) : q + BOUNDS_HALF_SIZE;
+    ivec3 index = clamp(ivec3(floor(g / volumeCell + 0.5)), ivec3(0), size - 1);
+    return texelFetch(distanceVolume, index, 0).r - length(objPos - q);
+}
 
-    orbitTrap = 1000.0;
+float brickCellSize() {
+    return (skipSymmetric ? 1.0 : 2.0) * BOUNDS_HALF_SIZE / float(textureSize(brickIndex, 0).x);
+}
 
-    for (int i = 0; i < maxIterations; i++) {
-        z = clamp(z, -1.0, 1.0) * 2.0 - z;
+// Mirrors BrickMap::lowerBound().
+float brickBound(vec3 objPos) {
+    vec3 q = clamp(objPos, -BOUNDS_HALF_SIZE, BOUNDS_HALF_SIZE);
+    float outside = length(objPos - q);
+
+    float cell = brickCellSize();
+    vec3 g = (skipSymmetric ? symmetryFold(q) : q + BOUNDS_HALF_SIZE) / cell;
+    ivec3 c = clamp(ivec3(floor(g)), ivec3(0), textureSize(brickIndex, 0) - 1);
+    vec2 entry = texelFetch(brickIndex, c, 0).rg;
+    if (entry.y < 0.0) {
+        return entry.x - outside;
+    }
 
-        float r2 = dot(z, z);
+    ivec3 v = clamp(ivec3(floor((g - vec3(c)) * float(BRICK_SIZE))), ivec3(0), ivec3(BRICK_SIZE - 1));
+    ivec3 bricks = textureSize(brickAtlas, 0) / BRICK_SIZE;
+    int id = int(entry.y);
+    ivec3 origin = ivec3(id % bricks.x, (id / bricks.x) % bricks.y, id / (bricks.x * bricks.y)) * BRICK_SIZE;
+    return texelFetch(brickAtlas, origin + v, 0).r * cell - outside;
+}
 
-        if (r2 < minRadius * minRadius) {
-            float t = (fixedRadius * fixedRadius) / (minRadius * minRadius);
-            z *= t;
-            dr *= t;
-        } else if (r2 < fixedRadius * fixedRadius) {
-            float t = (fixedRadius * fixedRadius) / r2;
-            z *= t;
-            dr *= t;
+// Mirrors DistanceClipmap::lowerBound().
+float clipmapBound(vec3 objPos) {
+    int size = textureSize(clipmapLevels, 0).x;
+    int levels = textureSize(clipmapBoxes, 0).y;
+    for (int l = 0; l < levels; l++) {
+        vec4 lo = texelFetch(clipmapBoxes, ivec2(0, l), 0);
+        vec3 hi = texelFetch(clipmapBoxes, ivec2(1, l), 0).xyz;
+        vec3 g = floor(objPos / lo.w + 0.5);
+        if (all(greaterThanEqual(g, lo.xyz)) && all(lessThan(g, hi))) {
+            ivec3 t = ivec3(mod(g, float(size)));
+            float bound = texelFetch(clipmapLevels, t + ivec3(0, 0, l * size), 0).r;
+            return bound >= lo.w ? bound : 0.0;
         }
-
-        z = z * scale + pos;
-        dr = dr * abs(scale) + 1.0;
-
-        orbitTrap = min(orbitTrap,
-                        abs(z.x) + abs(z.y) + abs(z.z));
     }
-
-    return length(z) / abs(dr);
+    return 0.0;
 }
 
-float sceneSDF(vec3 p, out float orbitTrap) {
-    vec3 objPos = p / scale;
-    
-    if (autoRotate) {
-        float angle = time * 0.1;
-        float s = sin(angle);
-        float c = cos(angle);
-        mat3 rotY = mat3(
-            c, 0.0, s,
-            0.0, 1.0, 0.0,
-            -s, 0.0, c
-        );
-        objPos = rotY * objPos;
+float skipBound(vec3 objPos) {
+    if (skipVolume == 1) {
+        return volumeBound(objPos);
     }
+    return skipVolume == 2 ? brickBound(objPos) : clipmapBound(objPos);
+}
 
-    return mandelboxDE(objPos, orbitTrap) * scale;
+// Object-space step below which the exact estimate takes over.
+float skipMinStep() {
+    if (skipVolume == 1) {
+        return volumeCell;
+    }
+    return skipVolume == 2 ? brickCellSize() / float(BRICK_SIZE) : texelFetch(clipmapBoxes, ivec2(0, 0), 0).w;
 }
 
-float rayMarch(vec3 ro, vec3 rd, out int steps, out bool hit, out float orbitTrap) {
-    float depth = 0.0;
+float rayMarch(vec3 ro, vec3 rd, float startDepth, float startTrap, out int steps, out bool hit, out float orbitTrap) {
+    float cone = pixelCone();
+    float maxDist = farLimit();
     steps = 0;
     hit = false;
-    orbitTrap = 1000.0;
+    orbitTrap = startTrap;
+
+    // Only the stretch of the ray inside the bounding cube is marched; sky
+    // pixels that miss it cost no estimates at all.
+    float entry, exit;
+    if (!boundsInterval(ro, rd, cone, entry, exit)) {
+        return maxDist;
+    }
+    float marchLimit = min(maxDist, exit);
+    float depth = entry;
+
+    // Big safe steps through empty space, down to a sample from the surface.
+    // They start at the entry rather than at startDepth: stepping on from the
+    // prepass depth lands nearer the surface than the exact march from there,
+    // whose last samples, orbit trap and shading would then differ.
+    if (skipVolume != 0) {
+        float minStep = skipMinStep() * scale;
+        for (int i = 0; i < MAX_STEPS && depth < marchLimit; i++) {
+            float step = skipBound(toObjectSpace(ro + rd * depth)) * scale;
+            if (step < minStep) {
+                break;
+            }
+            depth += step;
+        }
+    }
+    depth = max(depth, startDepth);
+    if (depth >= marchLimit) {
+        return maxDist;
+    }
+
+    float previousDepth = depth;
+    float previousDist = 0.0;
+    float omega = max(relaxation, 1.0);
     
     for (int i = 0; i < MAX_STEPS; i++) {
         steps = i;
         vec3 p = ro + rd * depth;
+        float epsilon = hitEpsilon(depth, cone);
         float trap;
-        float dist = sceneSDF(p, trap);
+        float dist = sceneSDF(p, iterationLod(epsilon), trap);
+
+        if (omega > 1.0 && dist + previousDist < depth - previousDepth) {
+            depth = previousDepth + previousDist;
+            omega = 1.0;
+            continue;
+        }
         
         orbitTrap = min(orbitTrap, trap);
 
-        if (dist < MIN_DIST) {
+        if (dist < epsilon) {
+            if (omega > 1.0) {
+                float lo = previousDepth;
+                float hi = depth;
+                for (int b = 0; b < BISECTION_STEPS; b++) {
+                    float mid = (lo + hi) * 0.5;
+                    float midEpsilon = hitEpsilon(mid, cone);
+                    float midTrap;
+                    if (sceneSDF(ro + rd * mid, iterationLod(midEpsilon), midTrap) < midEpsilon)
+                        hi = mid;
+                    else
+                        lo = mid;
+                }
+                depth = hi;
+            }
             hit = true;
             return depth;
         }
 
-        depth += dist;
+        previousDepth = depth;
+        previousDist = dist;
+        depth += dist * omega;
         
-        if (depth >= MAX_DIST) {
+        if (depth >= marchLimit) {
             break;
         }
     }
     
-    return MAX_DIST;
+    return maxDist;
 }
 
 vec3 calcNormal(vec3 p, float dist) {
-    float eps = 0.001;
+    float eps = hitEpsilon(dist, pixelCone());
+    float iterations = iterationLod(eps);
     float trap;
     
     vec2 e = vec2(eps, 0.0);
     return normalize(vec3(
-        sceneSDF(p + e.xyy, trap) - sceneSDF(p - e.xyy, trap),
-        sceneSDF(p + e.yxy, trap) - sceneSDF(p - e.yxy, trap),
-        sceneSDF(p + e.yyx, trap) - sceneSDF(p - e.yyx, trap)
+        sceneSDF(p + e.xyy, iterations, trap) - sceneSDF(p - e.xyy, iterations, trap),
+        sceneSDF(p + e.yxy, iterations, trap) - sceneSDF(p - e.yxy, iterations, trap),
+        sceneSDF(p + e.yyx, iterations, trap) - sceneSDF(p - e.yyx, iterations, trap)
     ));
 }
 
@@ -221,27 +349,37 @@ vec3 calculateLighting(vec3 p, vec3 normal, vec3 rd, float ao) {
     return (ambient + diffuse + specular + rimColor + skyColor) * ao;
 }
 
-float tanHalfFov = tan(fov / 2.0);
-
 void main() {
-    vec2 uv = (TexCoord * 2.0 - 1.0) * vec2(resolution.x / resolution.y, 1.0);
-
-    vec3 rd = normalize(
-        camFront + 
-        camRight * uv.x * tanHalfFov +
-        camUp * uv.y * tanHalfFov
-    );
-
+    vec3 rd = cameraRay(TexCoord + jitter / resolution.xy);
     vec3 ro = camPos;
 
+    float startDepth = 0.0;
+    float startTrap = 1000.0;
+    if (prepassTile > 0) {
+        // Depth must stay conservative, so no filtering; the trap is blended
+        // between blocks to avoid visible tile edges in the colouring.
+        startDepth = texelFetch(prepassDepth, ivec2(gl_FragCoord.xy) / prepassTile, 0).r;
+        vec2 blocks = vec2(textureSize(prepassDepth, 0));
+        startTrap = textureLod(prepassDepth, gl_FragCoord.xy / (blocks * float(prepassTile)), 0.0).g;
+    }
+    if (temporalFraction > 0.0) {
+        // Start a safe fraction short of where the surface was; the trap of
+        // the old ray keeps the colouring stable.
+        vec2 reprojected = texelFetch(reprojectedDepth, ivec2(gl_FragCoord.xy), 0).rg;
+        if (reprojected.x < REPROJECT_EMPTY) {
+            startDepth = max(startDepth, reprojected.x * temporalFraction);
+            startTrap = min(startTrap, reprojected.y);
+        }
+    }
+
     int steps;
     bool hit;
     float orbitTrap;
-    float dist = rayMarch(ro, rd, steps, hit, orbitTrap);
+    float dist = rayMarch(ro, rd, startDepth, startTrap, steps, hit, orbitTrap);
 
     vec3 color;
 
-    if (hit && dist < MAX_DIST) {
+    if (hit && dist < farLimit()) {
         vec3 p = ro + rd * dist;
         vec3 normal = calcNormal(p, dist);
         
@@ -280,7 +418,9 @@ void main() {
         color += vec3(star) * vec3(1.0, 0.95, 0.9);
     }
 
-    color = pow(color, vec3(1.0 / 2.2));
+    if (!linearOutput)
+        color = pow(color, vec3(1.0 / 2.2));
     
     FragColor = vec4(color, 1.0);
+    HitDepth = vec2(hit ? dist : farLimit(), orbitTrap);
 }
\ No newline at end of file
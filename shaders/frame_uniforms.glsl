@@ -0,0 +1,13 @@
+// Per-frame state, written by ShaderRenderer as one std140 block.
+layout(std140) uniform FrameUniforms {
+    vec3 camPos;
+    float fov;
+    vec3 camFront;
+    float time;
+    vec3 camRight;
+    float scale;
+    vec3 camUp;
+    int maxIterations;
+    vec3 resolution;
+    bool autoRotate;
+};
@@ -0,0 +1,11 @@
+#version 410 core
+
+// Blended with GL_MIN, so each pixel keeps the nearest reprojected surface
+// and the smallest orbit trap that landed on it.
+
+in vec2 Reprojected;
+out vec2 FragDepth;
+
+void main() {
+    FragDepth = Reprojected;
+}
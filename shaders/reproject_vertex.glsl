@@ -0,0 +1,57 @@
+#version 410 core
+
+// One point per pixel of the previous frame. Moves the surface point it saw
+// into the current view, in object space so zoom (scale) and autoRotate
+// changes are followed. Misses are dropped.
+
+#include "frame_uniforms.glsl"
+#include "scene.glsl"
+#include "camera.glsl"
+
+uniform sampler2D previousDepth;
+uniform vec3 previousCamPos;
+uniform vec3 previousCamFront;
+uniform vec3 previousCamRight;
+uniform vec3 previousCamUp;
+uniform float previousFov;
+uniform float previousScale;
+uniform float previousTime;
+
+out vec2 Reprojected;
+
+void main() {
+    ivec2 size = textureSize(previousDepth, 0);
+    ivec2 pixel = ivec2(gl_VertexID % size.x, gl_VertexID / size.x);
+    vec2 previous = texelFetch(previousDepth, pixel, 0).rg;
+
+    // Outside the clip volume, so the point is discarded.
+    gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+    gl_PointSize = 2.0;
+    Reprojected = previous;
+
+    if (previous.x >= MAX_DIST * previousScale) {
+        return;
+    }
+
+    vec2 texCoord = (vec2(pixel) + 0.5) / vec2(size);
+    vec3 rd = cameraRay(previousCamFront, previousCamRight, previousCamUp, previousFov, texCoord);
+    vec3 objPos = (previousCamPos + rd * previous.x) / previousScale;
+
+    vec3 worldPos = objPos;
+    if (ROTATION_ENABLED) {
+        worldPos = transpose(objectRotation(time)) * objectRotation(previousTime) * objPos;
+    }
+    vec3 rel = worldPos * scale - camPos;
+
+    float z = dot(rel, camFront);
+    if (z <= 0.0) {
+        return;
+    }
+
+    float tanHalfFov = tan(fov / 2.0);
+    vec2 ndc = vec2(dot(rel, camRight) / (resolution.x / resolution.y),
+                    dot(rel, camUp)) / (z * tanHalfFov);
+
+    gl_Position = vec4(ndc, 0.0, 1.0);
+    Reprojected = vec2(length(rel), previous.y);
+}
@@ -0,0 +1,185 @@
+// Mandelbox distance estimator and scene transform. Every knob below can be
+// injected as a define to build a specialised variant; without one the
+// runtime uniform is used.
+
+#ifndef MAX_STEPS
+#define MAX_STEPS 80
+#endif
+// Hit floor and far limit in object space; see hitEpsilon() and farLimit().
+const float MIN_DIST = 0.001;
+const float MAX_DIST = 100.0;
+// Beyond the floor, a ray hits once the surface is within this fraction of
+// its pixel's footprint; further steps could not change the pixel.
+#ifndef HIT_FOOTPRINT
+#define HIT_FOOTPRINT 0.5
+#endif
+
+#ifndef MANDELBOX_SCALE
+#define MANDELBOX_SCALE -1.5
+#endif
+#ifndef MANDELBOX_MIN_RADIUS
+#define MANDELBOX_MIN_RADIUS 0.5
+#endif
+#ifndef MANDELBOX_FIXED_RADIUS
+#define MANDELBOX_FIXED_RADIUS 2.25
+#endif
+// Squared escape radius of the fold loop. Past it z only grows and
+// length(z) / dr has settled to within a fraction of a percent.
+const float ESCAPE_RADIUS2 = 1.0e6;
+// Object-space size of the detail the first fold iteration adds; each further
+// iteration adds detail |MANDELBOX_SCALE| times finer. See iterationLod().
+#ifndef LOD_DETAIL
+#define LOD_DETAIL 1.0
+#endif
+// Half-size of the object-space cube around the fractal. With a negative
+// scale the set lies in [-2, 2]^3 and the estimate outside that cube is never
+// below the distance to it, so a march may start where a ray enters it.
+const float BOUNDS_HALF_SIZE = 2.0;
+
+// A constant trip count lets the driver unroll the fold loop.
+#ifdef MAX_ITERATIONS
+#define FOLD_ITERATIONS MAX_ITERATIONS
+#else
+#define FOLD_ITERATIONS maxIterations
+#endif
+
+// AUTO_ROTATE=0 drops the rotation from the variant entirely.
+#ifdef AUTO_ROTATE
+#define ROTATION_ENABLED bool(AUTO_ROTATE)
+#else
+#define ROTATION_ENABLED autoRotate
+#endif
+
+// iterations may be fractional: the estimate and orbit trap then blend between
+// the whole counts either side, so both stay continuous as the count changes.
+float mandelboxDE(vec3 pos, float iterations, out float orbitTrap) {
+    vec3 z = pos;
+    float dr = 1.0;
+
+    const float scale = MANDELBOX_SCALE;
+    const float minRadius = MANDELBOX_MIN_RADIUS;
+    const float fixedRadius = MANDELBOX_FIXED_RADIUS;
+
+    orbitTrap = 1000.0;
+
+    // Estimate and trap after the last whole iteration, for a fractional
+    // count.
+    float lower = -1.0;
+    float lowerTrap = 1000.0;
+    float blend = 0.0;
+
+    for (int i = 0; i < FOLD_ITERATIONS; i++) {
+        if (float(i) >= iterations) {
+            break;
+        }
+        if (float(i + 1) > iterations) {
+            lower = length(z) / abs(dr);
+            lowerTrap = orbitTrap;
+            blend = iterations - float(i);
+        }
+
+        z = clamp(z, -1.0, 1.0) * 2.0 - z;
+
+        float r2 = dot(z, z);
+
+        if (r2 < minRadius * minRadius) {
+            float t = (fixedRadius * fixedRadius) / (minRadius * minRadius);
+            z *= t;
+            dr *= t;
+        } else if (r2 < fixedRadius * fixedRadius) {
+            float t = (fixedRadius * fixedRadius) / r2;
+            z *= t;
+            dr *= t;
+        }
+
+        z = z * scale + pos;
+        dr = dr * abs(scale) + 1.0;
+
+        orbitTrap = min(orbitTrap,
+                        abs(z.x) + abs(z.y) + abs(z.z));
+
+        if (dot(z, z) > ESCAPE_RADIUS2) {
+            break;
+        }
+    }
+
+    float de = length(z) / abs(dr);
+    if (lower < 0.0) {
+        return de;
+    }
+    orbitTrap = mix(lowerTrap, orbitTrap, blend);
+    return mix(lower, de, blend);
+}
+
+// Rotation applied by autoRotate at a given time.
+mat3 objectRotation(float t) {
+    float angle = t * 0.1;
+    float s = sin(angle);
+    float c = cos(angle);
+    return mat3(
+        c, 0.0, s,
+        0.0, 1.0, 0.0,
+        -s, 0.0, c
+    );
+}
+
+vec3 toObjectSpace(vec3 p) {
+    vec3 objPos = p / scale;
+
+    if (ROTATION_ENABLED) {
+        objPos = objectRotation(time) * objPos;
+    }
+
+    return objPos;
+}
+
+// Angle between the rays of two vertically adjacent pixels at the centre of
+// the screen.
+float pixelCone() {
+    return 2.0 * tan(fov / 2.0) / resolution.y;
+}
+
+// Distances are world space, i.e. object space times scale, so both limits
+// scale with the zoom level.
+float hitEpsilon(float depth, float cone) {
+    return max(MIN_DIST * scale, depth * (cone * HIT_FOOTPRINT));
+}
+
+float farLimit() {
+    return MAX_DIST * scale;
+}
+
+// World-space depths at which a ray enters and leaves the bounding cube,
+// grown by the largest hit epsilon before farLimit() so grazing rays still
+// hit. toObjectSpace() is linear, so depths along the object-space ray stay
+// world-space. Returns false when the ray misses the cube.
+bool boundsInterval(vec3 ro, vec3 rd, float cone, out float entry, out float exit) {
+    vec3 o = toObjectSpace(ro);
+    vec3 d = toObjectSpace(rd);
+    float halfSize = BOUNDS_HALF_SIZE + hitEpsilon(farLimit(), cone) / scale;
+
+    vec3 inv = 1.0 / d;
+    vec3 t0 = (-halfSize - o) * inv;
+    vec3 t1 = (halfSize - o) * inv;
+    vec3 tMin = min(t0, t1);
+    vec3 tMax = max(t0, t1);
+
+    entry = max(max(tMin.x, tMin.y), max(tMin.z, 0.0));
+    exit = min(min(tMax.x, tMax.y), tMax.z);
+    return entry < exit;
+}
+
+// Fold iterations needed to resolve detail down to a hit epsilon, at most
+// FOLD_ITERATIONS. Not clamp(): that is undefined when FOLD_ITERATIONS is 0.
+float iterationLod(float epsilon) {
+    float n = log2(LOD_DETAIL * scale / epsilon) / log2(abs(MANDELBOX_SCALE));
+    return min(max(n, 1.0), float(FOLD_ITERATIONS));
+}
+
+float sceneSDF(vec3 p, float iterations, out float orbitTrap) {
+    return mandelboxDE(toObjectSpace(p), iterations, orbitTrap) * scale;
+}
+
+float sceneSDF(vec3 p, out float orbitTrap) {
+    return sceneSDF(p, float(FOLD_ITERATIONS), orbitTrap);
+}
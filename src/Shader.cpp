@@ -1,39 +1,226 @@
-#include "shader.h"
+#include "Shader.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <iterator>
 #include <iostream>
 #include <glm/gtc/type_ptr.hpp>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
-    std::string vertexCode = readFile(vertexPath);
-    std::string fragmentCode = readFile(fragmentPath);
-    
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+static const char BINARY_MAGIC[4] = { 'F', 'R', 'P', 'B' };
+
+static std::string defaultCacheDirectory() {
+    if (const char* path = std::getenv("FRACTAL_SHADER_CACHE"))
+        return path;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"))
+        return std::string(xdg) + "/fractal";
+    if (const char* home = std::getenv("HOME"))
+        return std::string(home) + "/.cache/fractal";
+    return "shader_cache";
+}
+
+static std::string& cacheDirectory() {
+    static std::string directory = defaultCacheDirectory();
+    return directory;
+}
+
+static bool hasParallelShaderCompile() {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (name && (std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0 ||
+                     std::strcmp(name, "GL_ARB_parallel_shader_compile") == 0))
+            return true;
+    }
+    return false;
+}
+
+// FNV-1a over the sources and the driver identity, so a driver update or a
+// different GPU never picks up a stale binary.
+static std::string programCacheKey(const std::string& vertexCode, const std::string& fragmentCode) {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const char* data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        hash ^= 0xff;
+        hash *= 1099511628211ull;
+    };
+
+    mix(vertexCode.data(), vertexCode.size());
+    mix(fragmentCode.data(), fragmentCode.size());
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        const char* value = reinterpret_cast<const char*>(glGetString(name));
+        if (value)
+            mix(value, std::strlen(value));
+    }
+
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+    return key;
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, bool async, const ShaderDefines& defines) {
+    build(readSource(vertexPath, defines), readSource(fragmentPath, defines), async, true);
+}
+
+std::unique_ptr<Shader> Shader::fromSource(const std::string& vertexCode, const std::string& fragmentCode) {
+    std::unique_ptr<Shader> shader(new Shader());
+    shader->build(vertexCode, fragmentCode, false, false);
+    return shader;
+}
+
+void Shader::setCacheDirectory(const std::string& path) {
+    cacheDirectory() = path;
+}
+
+void Shader::build(const std::string& vertexCode, const std::string& fragmentCode, bool async, bool useCache) {
+    ID = glCreateProgram();
+
+    if (useCache && !cacheDirectory().empty()) {
+        binaryPath = cacheDirectory() + "/" + programCacheKey(vertexCode, fragmentCode) + ".bin";
+        if (loadBinary()) {
+            linkSucceeded = true;
+            cached = true;
+            cacheUniformLocations();
+            return;
+        }
+    }
+
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
-    
-    GLuint vertex, fragment;
 
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
+    pendingVertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(pendingVertex, 1, &vShaderCode, NULL);
+    glCompileShader(pendingVertex);
 
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
+    pendingFragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(pendingFragment, 1, &fShaderCode, NULL);
+    glCompileShader(pendingFragment);
 
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
+    glAttachShader(ID, pendingVertex);
+    glAttachShader(ID, pendingFragment);
+    if (!binaryPath.empty())
+        glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(ID);
+    pending = true;
+
+    // Status queries block until the driver's compiler threads are done, so
+    // defer them to ready() when the link can run in the background.
+    if (!async || !hasParallelShaderCompile())
+        finishLink();
+}
+
+bool Shader::ready() {
+    if (!pending)
+        return true;
+
+    GLint complete = GL_TRUE;
+    glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &complete);
+    if (!complete)
+        return false;
+
+    finishLink();
+    return true;
+}
+
+void Shader::wait() {
+    if (pending)
+        finishLink();
+}
+
+void Shader::finishLink() {
+    pending = false;
+    checkCompileErrors(pendingVertex, "VERTEX");
+    checkCompileErrors(pendingFragment, "FRAGMENT");
     checkCompileErrors(ID, "PROGRAM");
-    
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+
+    glDeleteShader(pendingVertex);
+    glDeleteShader(pendingFragment);
+    pendingVertex = 0;
+    pendingFragment = 0;
+
+    GLint linked = 0;
+    glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+    linkSucceeded = linked == GL_TRUE;
+    if (!linkSucceeded)
+        return;
+
+    cacheUniformLocations();
+    if (!binaryPath.empty())
+        saveBinary();
+}
+
+bool Shader::loadBinary() {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats == 0)
+        return false;
+
+    std::ifstream file(binaryPath, std::ios::binary);
+    if (!file)
+        return false;
+
+    char magic[4];
+    GLenum format = 0;
+    std::string binary;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&format), sizeof(format));
+    if (!file)
+        return false;
+    binary.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) != 0 || binary.empty())
+        return false;
+
+    glProgramBinary(ID, format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // Drivers may reject binaries from other versions; relink from source then.
+    GLint linked = 0;
+    glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+    return linked == GL_TRUE;
+}
+
+void Shader::saveBinary() const {
+    GLint length = 0;
+    glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::string binary(length, '\0');
+    GLenum format = 0;
+    glGetProgramBinary(ID, length, nullptr, &format, &binary[0]);
+
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory(), error);
+
+    // Write to a temporary name first so a concurrent start never reads half a file.
+    std::string tempPath = binaryPath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "ERROR::SHADER::CACHE_NOT_WRITABLE: " << tempPath << std::endl;
+            return;
+        }
+        file.write(BINARY_MAGIC, 4);
+        file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+        file.write(binary.data(), binary.size());
+    }
+    std::filesystem::rename(tempPath, binaryPath, error);
 }
 
 Shader::~Shader() {
+    if (pending) {
+        glDeleteShader(pendingVertex);
+        glDeleteShader(pendingFragment);
+    }
     glDeleteProgram(ID);
 }
 
@@ -41,28 +228,100 @@ void Shader::use() const {
     glUseProgram(ID);
 }
 
+GLint Shader::uniformLocation(const std::string& name) const {
+    auto it = locations.find(name);
+    return it == locations.end() ? -1 : it->second;
+}
+
+bool Shader::bindUniformBlock(const std::string& name, GLuint binding) const {
+    GLuint index = glGetUniformBlockIndex(ID, name.c_str());
+    if (index == GL_INVALID_INDEX)
+        return false;
+    glUniformBlockBinding(ID, index, binding);
+    return true;
+}
+
 void Shader::setBool(const std::string& name, bool value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    glUniform1i(uniformLocation(name), (int)value);
 }
 
 void Shader::setInt(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1i(uniformLocation(name), value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1f(uniformLocation(name), value);
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+    glUniform3fv(uniformLocation(name), 1, glm::value_ptr(value));
 }
 
 void Shader::setVec3(const std::string& name, float x, float y, float z) const {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    glUniform3f(uniformLocation(name), x, y, z);
 }
 
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+    glUniformMatrix4fv(uniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void uploadUniform(GLint location, bool value) {
+    glUniform1i(location, (int)value);
+}
+
+void uploadUniform(GLint location, int value) {
+    glUniform1i(location, value);
+}
+
+void uploadUniform(GLint location, float value) {
+    glUniform1f(location, value);
+}
+
+void uploadUniform(GLint location, const glm::vec2& value) {
+    glUniform2fv(location, 1, glm::value_ptr(value));
+}
+
+void uploadUniform(GLint location, const glm::vec3& value) {
+    glUniform3fv(location, 1, glm::value_ptr(value));
+}
+
+void uploadUniform(GLint location, const glm::mat4& value) {
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+// Resolves every active uniform once after linking, so setters never hit the
+// driver's string lookup.
+void Shader::cacheUniformLocations() {
+    locations.clear();
+
+    GLint linked = 0;
+    glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+    if (!linked)
+        return;
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::string name(maxLength > 0 ? maxLength : 1, '\0');
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, i, maxLength, &length, &size, &type, &name[0]);
+        std::string uniformName(name.data(), length);
+
+        // Members of uniform blocks have no location.
+        GLint location = glGetUniformLocation(ID, uniformName.c_str());
+        if (location < 0)
+            continue;
+
+        locations[uniformName] = location;
+        // Arrays are reported as "name[0]"; make the bare name resolve too.
+        size_t bracket = uniformName.find("[0]");
+        if (bracket != std::string::npos)
+            locations[uniformName.substr(0, bracket)] = location;
+    }
 }
 
 void Shader::checkCompileErrors(GLuint shader, const std::string& type) {
@@ -86,21 +345,9 @@ void Shader::checkCompileErrors(GLuint shader, const std::string& type) {
     }
 }
 
-std::string Shader::readFile(const char* filePath) {
-    std::string code;
-    std::ifstream file;
-    
-    file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    
-    try {
-        file.open(filePath);
-        std::stringstream stream;
-        stream << file.rdbuf();
-        file.close();
-        code = stream.str();
-    } catch (std::ifstream::failure& e) {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << filePath << std::endl;
-    }
-    
+std::string Shader::readSource(const char* filePath, const ShaderDefines& defines) {
+    std::string code, error;
+    if (!preprocessShader(filePath, defines, code, error))
+        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << filePath << ": " << error << std::endl;
     return code;
-}
\ No newline at end of file
+}
@@ -0,0 +1,254 @@
+#include "brick_map.h"
+#include "distance_volume.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+static const char BRICK_MAGIC[4] = { 'F', 'R', 'B', 'M' };
+static const uint32_t BRICK_VERSION = 2;
+
+// Everything a build depends on; the index, bounds and bricks follow.
+struct BrickHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t cells;
+    int32_t brickSize;
+    int32_t iterations;
+    float halfSize;
+    float mandelboxScale;
+    float minRadius;
+    float fixedRadius;
+    int32_t symmetric;
+    int32_t brickCount;
+};
+
+static BrickHeader makeHeader(int cells, int iterations, bool symmetric) {
+    BrickHeader header;
+    std::memcpy(header.magic, BRICK_MAGIC, sizeof(header.magic));
+    header.version = BRICK_VERSION;
+    header.cells = cells;
+    header.brickSize = BrickMap::BRICK_SIZE;
+    header.iterations = iterations;
+    header.halfSize = BOUNDS_HALF_SIZE;
+    header.mandelboxScale = MANDELBOX_SCALE;
+    header.minRadius = MANDELBOX_MIN_RADIUS;
+    header.fixedRadius = MANDELBOX_FIXED_RADIUS;
+    header.symmetric = symmetric ? 1 : 0;
+    header.brickCount = 0;
+    return header;
+}
+
+float BrickMap::cellSize() const {
+    return 2.0f * BOUNDS_HALF_SIZE / static_cast<float>(cellCount);
+}
+
+static size_t indexSize(int cells, bool symmetric) {
+    if (symmetric)
+        return DistanceVolume::wedgeIndex(cells / 2, 0, 0);
+    return static_cast<size_t>(cells) * cells * cells;
+}
+
+size_t BrickMap::cellIndex(const glm::ivec3& c) const {
+    if (folded)
+        return DistanceVolume::wedgeIndex(c.x, c.y, c.z);
+    return (static_cast<size_t>(c.z) * cellCount + c.y) * cellCount + c.x;
+}
+
+size_t BrickMap::memoryBytes() const {
+    return bounds.size() * sizeof(float) + indices.size() * sizeof(int32_t) + bricks.size();
+}
+
+void BrickMap::build(int cells, int iterations, ThreadPool& pool, bool symmetric) {
+    cellCount = symmetric ? cells + (cells & 1) : cells;
+    count = iterations;
+    folded = symmetric;
+
+    // Index coordinates of every entry, and where they start in object space.
+    const int side = indexCells();
+    std::vector<glm::ivec3> coords;
+    coords.reserve(indexSize(cellCount, folded));
+    for (int outer = 0; outer < side; outer++) {
+        for (int middle = 0; middle < (folded ? outer + 1 : side); middle++) {
+            for (int inner = 0; inner < (folded ? middle + 1 : side); inner++)
+                coords.push_back(folded ? glm::ivec3(outer, middle, inner) : glm::ivec3(inner, middle, outer));
+        }
+    }
+    const float start = folded ? 0.0f : -BOUNDS_HALF_SIZE;
+
+    size_t total = coords.size();
+    bounds.assign(total, 0.0f);
+    indices.assign(total, -1);
+    bricks.clear();
+
+    const float cell = cellSize();
+    const float voxel = voxelSize();
+    const float sqrt3 = std::sqrt(3.0f);
+
+    // Coarse pass: the estimate at the cell centre, less half the cell's
+    // diagonal, holds anywhere in the cell.
+    pool.parallelFor(total, [&](size_t c) {
+        glm::vec3 centre = (glm::vec3(coords[c]) + 0.5f) * cell + start;
+        bounds[c] = mandelboxDEMin(centre, iterations) - 0.5f * cell * sqrt3;
+    });
+
+    // Refine cells whose bound would not even step across them.
+    std::vector<size_t> refined;
+    for (size_t c = 0; c < total; c++) {
+        if (bounds[c] < cell) {
+            indices[c] = static_cast<int32_t>(refined.size());
+            refined.push_back(c);
+        }
+    }
+
+    bricks.resize(refined.size() * BRICK_VOXELS);
+    pool.parallelFor(refined.size(), [&](size_t b) {
+        glm::ivec3 c = coords[refined[b]];
+        glm::vec3 origin = glm::vec3(c) * cell + start;
+        uint8_t* out = &bricks[b * BRICK_VOXELS];
+        for (int v = 0; v < BRICK_VOXELS; v++) {
+            glm::ivec3 offset(v % BRICK_SIZE, (v / BRICK_SIZE) % BRICK_SIZE, v / (BRICK_SIZE * BRICK_SIZE));
+            // A folded lookup never reaches the part of a cell on the mirror
+            // plane beyond it.
+            if (folded && ((c.x == c.y && offset.x < offset.y) || (c.y == c.z && offset.y < offset.z))) {
+                out[v] = 0;
+                continue;
+            }
+            glm::vec3 centre = origin + (glm::vec3(offset) + 0.5f) * voxel;
+            float distance = mandelboxDEMin(centre, iterations) - 0.5f * voxel * sqrt3;
+            // Rounded down, so the quantised value never overstates it.
+            out[v] = static_cast<uint8_t>(std::floor(glm::clamp(distance / cell, 0.0f, 1.0f) * 255.0f));
+        }
+    });
+}
+
+bool BrickMap::save(const std::string& path) const {
+    if (empty())
+        return false;
+
+    // Write to a temporary name first so a concurrent start never reads half a file.
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "ERROR::BRICKS::CACHE_NOT_WRITABLE: " << tempPath << std::endl;
+            return false;
+        }
+        BrickHeader header = makeHeader(cellCount, count, folded);
+        header.brickCount = brickCount();
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(bounds.data()),
+                   static_cast<std::streamsize>(bounds.size() * sizeof(float)));
+        file.write(reinterpret_cast<const char*>(indices.data()),
+                   static_cast<std::streamsize>(indices.size() * sizeof(int32_t)));
+        file.write(reinterpret_cast<const char*>(bricks.data()), static_cast<std::streamsize>(bricks.size()));
+        if (!file)
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    return !error;
+}
+
+bool BrickMap::read(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    BrickHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
+    bool symmetric = header.symmetric == 1;
+    BrickHeader expected = makeHeader(header.cells, header.iterations, symmetric);
+    expected.brickCount = header.brickCount;
+    if (std::memcmp(&header, &expected, sizeof(header)) != 0 || header.cells < 1 || header.brickCount < 0 ||
+        (symmetric && header.cells % 2 != 0))
+        return false;
+
+    size_t total = indexSize(header.cells, symmetric);
+    std::vector<float> fileBounds(total);
+    std::vector<int32_t> fileIndices(total);
+    std::vector<uint8_t> fileBricks(static_cast<size_t>(header.brickCount) * BRICK_VOXELS);
+    file.read(reinterpret_cast<char*>(fileBounds.data()), static_cast<std::streamsize>(total * sizeof(float)));
+    file.read(reinterpret_cast<char*>(fileIndices.data()), static_cast<std::streamsize>(total * sizeof(int32_t)));
+    file.read(reinterpret_cast<char*>(fileBricks.data()), static_cast<std::streamsize>(fileBricks.size()));
+    if (!file)
+        return false;
+    for (int32_t index : fileIndices) {
+        if (index >= header.brickCount)
+            return false;
+    }
+
+    cellCount = header.cells;
+    count = header.iterations;
+    folded = symmetric;
+    bounds.swap(fileBounds);
+    indices.swap(fileIndices);
+    bricks.swap(fileBricks);
+    return true;
+}
+
+bool BrickMap::load(const std::string& directory, int cells, int iterations, ThreadPool& pool, bool symmetric) {
+    if (cells < 1 || iterations < 1)
+        return false;
+    if (symmetric)
+        cells += cells & 1;
+
+    std::string path;
+    if (!directory.empty()) {
+        path = directory + "/" + cacheFileName(cells, iterations, symmetric);
+        if (read(path) && cellCount == cells && count == iterations && folded == symmetric)
+            return true;
+    }
+
+    std::cout << "Building " << (symmetric ? "symmetric " : "") << "brick map, " << cells * BRICK_SIZE
+              << "^3 samples at " << iterations << " iterations..." << std::endl;
+    build(cells, iterations, pool, symmetric);
+    if (!path.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        save(path);
+    }
+    return true;
+}
+
+// FNV-1a over the header, so a change to the Mandelbox constants or the file
+// layout never picks up a stale build.
+std::string BrickMap::cacheFileName(int cells, int iterations, bool symmetric) {
+    BrickHeader header = makeHeader(cells, iterations, symmetric);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&header);
+
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < sizeof(header); i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    char name[40];
+    std::snprintf(name, sizeof(name), "bricks_%016llx.bin", static_cast<unsigned long long>(hash));
+    return name;
+}
+
+float BrickMap::lowerBound(const glm::vec3& objPos) const {
+    glm::vec3 q = glm::clamp(objPos, -BOUNDS_HALF_SIZE, BOUNDS_HALF_SIZE);
+    float outside = glm::length(objPos - q);
+
+    // Flooring keeps the fold's ordering, so the cell is in the wedge.
+    const float cell = cellSize();
+    glm::vec3 g = folded ? symmetryFold(q) / cell : (q + BOUNDS_HALF_SIZE) / cell;
+    glm::ivec3 c = glm::clamp(glm::ivec3(glm::floor(g)), glm::ivec3(0), glm::ivec3(indexCells() - 1));
+    size_t index = cellIndex(c);
+
+    int32_t brick = indices[index];
+    if (brick < 0)
+        return bounds[index] - outside;
+
+    glm::ivec3 v = glm::clamp(glm::ivec3(glm::floor((g - glm::vec3(c)) * static_cast<float>(BRICK_SIZE))),
+                              glm::ivec3(0), glm::ivec3(BRICK_SIZE - 1));
+    uint8_t sample = bricks[static_cast<size_t>(brick) * BRICK_VOXELS + (v.z * BRICK_SIZE + v.y) * BRICK_SIZE + v.x];
+    return static_cast<float>(sample) / 255.0f * cell - outside;
+}
@@ -0,0 +1,109 @@
+#include "camera_script.h"
+#include "json.h"
+#include <algorithm>
+
+static bool readInt(const JsonValue& object, const char* key, int& out, std::string& error) {
+    const JsonValue* value = object.find(key);
+    if (!value)
+        return true;
+    if (!value->isNumber()) {
+        error = std::string("'") + key + "' must be a number";
+        return false;
+    }
+    out = static_cast<int>(value->number);
+    return true;
+}
+
+static bool readFloat(const JsonValue& object, const char* key, float& out, std::string& error) {
+    const JsonValue* value = object.find(key);
+    if (!value)
+        return true;
+    if (!value->isNumber()) {
+        error = std::string("'") + key + "' must be a number";
+        return false;
+    }
+    out = static_cast<float>(value->number);
+    return true;
+}
+
+bool CameraScript::load(const char* filePath, std::string& error) {
+    JsonValue root;
+    if (!readJsonFile(filePath, root, error))
+        return false;
+
+    if (!readInt(root, "width", Width, error) ||
+        !readInt(root, "height", Height, error) ||
+        !readInt(root, "frames", FrameCount, error) ||
+        !readInt(root, "warmup", WarmupFrames, error))
+        return false;
+
+    if (Width <= 0 || Height <= 0 || FrameCount <= 0 || WarmupFrames < 0) {
+        error = "width, height and frames must be positive";
+        return false;
+    }
+
+    const JsonValue* keys = root.find("keyframes");
+    if (!keys || !keys->isArray() || keys->array.empty()) {
+        error = "'keyframes' must be a non-empty array";
+        return false;
+    }
+
+    Keys.clear();
+    CameraKey previous;
+    for (const JsonValue& entry : keys->array) {
+        if (!entry.isObject()) {
+            error = "keyframes must be objects";
+            return false;
+        }
+
+        // Unspecified fields carry over from the previous keyframe.
+        CameraKey key = previous;
+        if (const JsonValue* mantissa = entry.find("mantissa")) {
+            if (!mantissa->isArray() || mantissa->array.size() != 3 ||
+                !mantissa->array[0].isNumber() || !mantissa->array[1].isNumber() || !mantissa->array[2].isNumber()) {
+                error = "'mantissa' must be an array of three numbers";
+                return false;
+            }
+            key.mantissa = glm::vec3(mantissa->array[0].number, mantissa->array[1].number, mantissa->array[2].number);
+        }
+
+        if (!readInt(entry, "frame", key.frame, error) ||
+            !readInt(entry, "exponent", key.exponent, error) ||
+            !readFloat(entry, "yaw", key.yaw, error) ||
+            !readFloat(entry, "pitch", key.pitch, error) ||
+            !readInt(entry, "maxIterations", key.maxIterations, error) ||
+            !readFloat(entry, "time", key.time, error))
+            return false;
+
+        if (!Keys.empty() && key.frame <= Keys.back().frame) {
+            error = "keyframe frames must be strictly increasing";
+            return false;
+        }
+
+        Keys.push_back(key);
+        previous = key;
+    }
+
+    return true;
+}
+
+CameraKey CameraScript::sample(int frame) const {
+    if (frame <= Keys.front().frame)
+        return Keys.front();
+    if (frame >= Keys.back().frame)
+        return Keys.back();
+
+    auto next = std::upper_bound(Keys.begin(), Keys.end(), frame,
+                                 [](int f, const CameraKey& key) { return f < key.frame; });
+    const CameraKey& b = *next;
+    const CameraKey& a = *(next - 1);
+    float t = static_cast<float>(frame - a.frame) / static_cast<float>(b.frame - a.frame);
+
+    CameraKey key = a;
+    key.frame = frame;
+    key.mantissa = glm::mix(a.mantissa, b.mantissa, t);
+    key.yaw = glm::mix(a.yaw, b.yaw, t);
+    key.pitch = glm::mix(a.pitch, b.pitch, t);
+    key.time = glm::mix(a.time, b.time, t);
+    return key;
+}
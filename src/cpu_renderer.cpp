@@ -0,0 +1,179 @@
+#include "cpu_renderer.h"
+#include "packet_march.h"
+#include "shading.h"
+#include <algorithm>
+#include <cstdint>
+
+static uint32_t spreadBits(uint32_t v) {
+    v &= 0xFFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+static uint32_t mortonCode(int x, int y) {
+    return spreadBits(static_cast<uint32_t>(x)) | (spreadBits(static_cast<uint32_t>(y)) << 1);
+}
+
+CpuRenderer::CpuRenderer(unsigned threadCount) : pool(threadCount) {
+}
+
+void CpuRenderer::buildTiles(int width, int height) {
+    if (width == tilesWidth && height == tilesHeight && TileSize == tilesSize)
+        return;
+
+    int tilesX = (width + TileSize - 1) / TileSize;
+    int tilesY = (height + TileSize - 1) / TileSize;
+
+    std::vector<std::pair<uint32_t, glm::ivec2>> ordered;
+    ordered.reserve(static_cast<size_t>(tilesX) * tilesY);
+    for (int ty = 0; ty < tilesY; ty++) {
+        for (int tx = 0; tx < tilesX; tx++)
+            ordered.push_back({ mortonCode(tx, ty), glm::ivec2(tx * TileSize, ty * TileSize) });
+    }
+    std::sort(ordered.begin(), ordered.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    tiles.clear();
+    for (const auto& entry : ordered)
+        tiles.push_back(entry.second);
+
+    tilesWidth = width;
+    tilesHeight = height;
+    tilesSize = TileSize;
+}
+
+// shaders/depth_prepass.glsl for the block at block (y up): one cone down the
+// block's axis, stopping where the estimate minus the cone's spread drops
+// below the hit floor.
+static glm::vec2 prepassCone(const ViewParams& view, int tile, const glm::ivec2& block, int& evaluations) {
+    const glm::vec2 resolution(static_cast<float>(view.width), static_cast<float>(view.height));
+    glm::vec2 blockMin = glm::vec2(block) * static_cast<float>(tile);
+    glm::vec2 blockMax = glm::min(blockMin + static_cast<float>(tile), resolution);
+
+    glm::vec3 axis = primaryRayDir(view, (blockMin + blockMax) * 0.5f / resolution);
+
+    float spread = glm::length(primaryRayDir(view, blockMin / resolution) - axis);
+    spread = std::max(spread, glm::length(primaryRayDir(view, glm::vec2(blockMax.x, blockMin.y) / resolution) - axis));
+    spread = std::max(spread, glm::length(primaryRayDir(view, glm::vec2(blockMin.x, blockMax.y) / resolution) - axis));
+    spread = std::max(spread, glm::length(primaryRayDir(view, blockMax / resolution) - axis));
+
+    const FractalParams& params = view.fractal;
+    const float cone = pixelCone(view);
+    const float minDist = MIN_DIST * params.scale;
+    const float maxDist = farLimit(params);
+    float depth = 0.0f;
+    float orbitTrap = 1000.0f;
+    for (int i = 0; i < MAX_STEPS; i++) {
+        float trap;
+        float iterations = iterationLod(hitEpsilon(depth, cone, params), params);
+        float step = sceneSDF(view.camPos + axis * depth, params, iterations, trap) - depth * spread;
+        evaluations++;
+        if (step < minDist)
+            break;
+
+        orbitTrap = std::min(orbitTrap, trap);
+
+        depth += step;
+
+        if (depth >= maxDist)
+            break;
+    }
+
+    return glm::vec2(std::min(depth, maxDist), orbitTrap);
+}
+
+void CpuRenderer::runPrepass(const ViewParams& view) {
+    prepassBlocks = glm::ivec2((view.width + PrepassTile - 1) / PrepassTile,
+                               (view.height + PrepassTile - 1) / PrepassTile);
+    prepass.resize(static_cast<size_t>(prepassBlocks.x) * prepassBlocks.y);
+    pool.parallelFor(prepass.size(), [&](size_t i) {
+        glm::ivec2 block(static_cast<int>(i % prepassBlocks.x), static_cast<int>(i / prepassBlocks.x));
+        int blockEvaluations = 0;
+        prepass[i] = prepassCone(view, PrepassTile, block, blockEvaluations);
+        evaluations.fetch_add(blockEvaluations, std::memory_order_relaxed);
+    });
+}
+
+// What fragment.glsl reads from the prepass target for the pixel at fragCoord
+// (y up): the depth of its own block, and the trap filtered bilinearly
+// between blocks with the edges clamped, as the texture unit does.
+glm::vec2 CpuRenderer::prepassStart(const glm::ivec2& fragCoord) const {
+    glm::ivec2 block = fragCoord / PrepassTile;
+    float depth = prepass[static_cast<size_t>(block.y) * prepassBlocks.x + block.x].x;
+
+    glm::vec2 blocks(prepassBlocks);
+    glm::vec2 uv = (glm::vec2(fragCoord) + 0.5f) / (blocks * static_cast<float>(PrepassTile));
+    glm::vec2 texel = uv * blocks - 0.5f;
+    glm::vec2 base = glm::floor(texel);
+    glm::vec2 f = texel - base;
+    glm::ivec2 lo = glm::clamp(glm::ivec2(base), glm::ivec2(0), prepassBlocks - 1);
+    glm::ivec2 hi = glm::clamp(glm::ivec2(base) + 1, glm::ivec2(0), prepassBlocks - 1);
+    auto trapAt = [&](int x, int y) { return prepass[static_cast<size_t>(y) * prepassBlocks.x + x].y; };
+    float bottom = glm::mix(trapAt(lo.x, lo.y), trapAt(hi.x, lo.y), f.x);
+    float top = glm::mix(trapAt(lo.x, hi.y), trapAt(hi.x, hi.y), f.x);
+    return glm::vec2(depth, glm::mix(bottom, top, f.y));
+}
+
+void CpuRenderer::render(const ViewParams& view, std::vector<glm::vec3>& pixels) {
+    pixels.resize(static_cast<size_t>(view.width) * view.height);
+    buildTiles(view.width, view.height);
+
+    evaluations.store(0, std::memory_order_relaxed);
+    if (PrepassTile > 0)
+        runPrepass(view);
+    pool.parallelFor(tiles.size(), [&](size_t i) {
+        renderTile(view, tiles[i], pixels);
+    });
+    lastEvaluationsPerPixel = static_cast<double>(evaluations.load(std::memory_order_relaxed)) /
+                              static_cast<double>(pixels.size());
+}
+
+void CpuRenderer::renderTile(const ViewParams& view, const glm::ivec2& origin,
+                             std::vector<glm::vec3>& pixels) {
+    thread_local RayBatch rays;
+    thread_local MarchBatch marched;
+
+    int x1 = std::min(origin.x + TileSize, view.width);
+    int y1 = std::min(origin.y + TileSize, view.height);
+    int tileW = x1 - origin.x;
+
+    rays.resize(static_cast<size_t>(tileW) * (y1 - origin.y));
+    for (int y = origin.y; y < y1; y++) {
+        for (int x = origin.x; x < x1; x++) {
+            // Row 0 is the top of the image; TexCoord.y grows upwards.
+            glm::vec2 texCoord((x + 0.5f) / view.width, 1.0f - (y + 0.5f) / view.height);
+            size_t i = static_cast<size_t>(y - origin.y) * tileW + (x - origin.x);
+            glm::vec2 start(0.0f, 1000.0f);
+            if (PrepassTile > 0)
+                start = prepassStart(glm::ivec2(x, view.height - 1 - y));
+            rays.set(i, view.camPos, primaryRayDir(view, texCoord), start.x, start.y);
+        }
+    }
+
+    MarchSettings settings;
+    settings.pixelCone = pixelCone(view);
+    settings.relaxation = Relaxation;
+    settings.volume = Volume;
+    marchRays(rays, view.fractal, marched, settings);
+
+    long long tileEvaluations = 0;
+    for (int y = origin.y; y < y1; y++) {
+        for (int x = origin.x; x < x1; x++) {
+            size_t i = static_cast<size_t>(y - origin.y) * tileW + (x - origin.x);
+            MarchResult march;
+            march.depth = marched.depth[i];
+            march.steps = marched.steps[i];
+            march.hit = marched.hit[i] != 0;
+            march.orbitTrap = marched.orbitTrap[i];
+            march.evaluations = marched.evaluations[i];
+            tileEvaluations += march.evaluations;
+
+            glm::vec3 rd(rays.dx[i], rays.dy[i], rays.dz[i]);
+            pixels[static_cast<size_t>(y) * view.width + x] = shadePixel(view.camPos, rd, march, view.fractal, settings.pixelCone);
+        }
+    }
+    evaluations.fetch_add(tileEvaluations, std::memory_order_relaxed);
+}
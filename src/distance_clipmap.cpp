@@ -0,0 +1,147 @@
+#include "distance_clipmap.h"
+#include <algorithm>
+#include <cmath>
+
+DistanceClipmap::DistanceClipmap(int size) : side(std::max(2, size + (size & 1))) {
+    // The coarsest level is as wide as the bounding cube, around the camera.
+    baseVoxel = 2.0f * BOUNDS_HALF_SIZE / static_cast<float>(side << (LEVELS - 1));
+    for (Level& level : levels)
+        level.samples.assign(static_cast<size_t>(side) * side * side, 0.0f);
+}
+
+float DistanceClipmap::voxelSize(int level) const {
+    return std::ldexp(baseVoxel, level);
+}
+
+bool DistanceClipmap::complete() const {
+    for (const Level& level : levels) {
+        if (level.validMin != level.origin || level.validMax != level.origin + side)
+            return false;
+    }
+    return count >= 1;
+}
+
+size_t DistanceClipmap::slot(const glm::ivec3& g) const {
+    glm::ivec3 t = ((g % side) + side) % side;
+    return (static_cast<size_t>(t.z) * side + t.y) * side + t.x;
+}
+
+void DistanceClipmap::evaluate(Level& level, float voxel, const glm::ivec3& lo, const glm::ivec3& hi,
+                               ThreadPool& pool) {
+    // Every point is within half a sample diagonal of its nearest sample.
+    const float reach = 0.5f * voxel * std::sqrt(3.0f);
+    glm::ivec3 extent = hi - lo;
+    pool.parallelFor(static_cast<size_t>(extent.y) * extent.z, [&](size_t row) {
+        int y = lo.y + static_cast<int>(row % extent.y);
+        int z = lo.z + static_cast<int>(row / extent.y);
+        for (int x = lo.x; x < hi.x; x++) {
+            glm::ivec3 g(x, y, z);
+            level.samples[slot(g)] = mandelboxDEMin(glm::vec3(g) * voxel, count) - reach;
+        }
+    });
+}
+
+size_t DistanceClipmap::update(const glm::vec3& centre, int iterations, size_t budget, ThreadPool& pool) {
+    if (iterations != count) {
+        count = iterations;
+        for (Level& level : levels) {
+            level.validMin = level.validMax = level.origin;
+            level.version++;
+        }
+    }
+
+    // Samples the new window shares with the old one stay where they are;
+    // only the valid box shrinks to the overlap.
+    for (int i = 0; i < LEVELS; i++) {
+        Level& level = levels[i];
+        glm::ivec3 origin = glm::ivec3(glm::floor(centre / voxelSize(i) + 0.5f)) - side / 2;
+        if (origin == level.origin)
+            continue;
+
+        glm::ivec3 lo = glm::max(level.validMin, origin);
+        glm::ivec3 hi = glm::min(level.validMax, origin + side);
+        if (glm::any(glm::lessThanEqual(hi, lo)))
+            lo = hi = origin;
+        level.origin = origin;
+        level.validMin = lo;
+        level.validMax = hi;
+        level.version++;
+    }
+
+    if (count < 1)
+        return 0;
+
+    size_t evaluated = 0;
+    for (int i = 0; i < LEVELS; i++)
+        evaluated += growLevel(i, budget > evaluated ? budget - evaluated : 0, evaluated == 0, pool);
+    return evaluated;
+}
+
+// Grows the valid box one slab at a time, cycling through its faces, until it
+// fills the window or the next slab would exceed budget. A level that has
+// nothing starts from the sample at the centre of its window.
+size_t DistanceClipmap::growLevel(int index, size_t budget, bool force, ThreadPool& pool) {
+    Level& level = levels[index];
+    const float voxel = voxelSize(index);
+    const glm::ivec3 end = level.origin + side;
+
+    size_t evaluated = 0;
+    for (;;) {
+        glm::ivec3 lo, hi;
+        int face = -1;
+        if (level.validMin == level.validMax) {
+            lo = level.origin + side / 2;
+            hi = lo + 1;
+        } else {
+            for (int i = 0; i < 6 && face < 0; i++) {
+                int f = (level.nextFace + i) % 6;
+                int axis = f / 2;
+                if (f % 2 == 0 ? level.validMin[axis] > level.origin[axis] : level.validMax[axis] < end[axis])
+                    face = f;
+            }
+            if (face < 0)
+                return evaluated;
+
+            int axis = face / 2;
+            lo = level.validMin;
+            hi = level.validMax;
+            if (face % 2 == 0) {
+                lo[axis]--;
+                hi[axis] = lo[axis] + 1;
+            } else {
+                lo[axis] = hi[axis];
+                hi[axis]++;
+            }
+        }
+
+        glm::ivec3 extent = hi - lo;
+        size_t cost = static_cast<size_t>(extent.x) * extent.y * extent.z;
+        if (evaluated + cost > budget && !(force && evaluated == 0))
+            return evaluated;
+
+        evaluate(level, voxel, lo, hi, pool);
+        evaluated += cost;
+        level.version++;
+        if (face < 0) {
+            level.validMin = lo;
+            level.validMax = hi;
+        } else {
+            level.validMin = glm::min(level.validMin, lo);
+            level.validMax = glm::max(level.validMax, hi);
+            level.nextFace = (face + 1) % 6;
+        }
+    }
+}
+
+float DistanceClipmap::lowerBound(const glm::vec3& objPos) const {
+    for (int i = 0; i < LEVELS; i++) {
+        const Level& level = levels[i];
+        const float voxel = voxelSize(i);
+        glm::ivec3 g = glm::ivec3(glm::floor(objPos / voxel + 0.5f));
+        if (glm::all(glm::greaterThanEqual(g, level.validMin)) && glm::all(glm::lessThan(g, level.validMax))) {
+            float bound = level.samples[slot(g)];
+            return bound >= voxel ? bound : 0.0f;
+        }
+    }
+    return 0.0f;
+}
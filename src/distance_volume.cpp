@@ -0,0 +1,293 @@
+#include "distance_volume.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char VOLUME_MAGIC[4] = { 'F', 'R', 'D', 'V' };
+static const uint32_t VOLUME_VERSION = 2;
+static const uint32_t VOLUME_SYMMETRIC = 1;
+
+// Everything a bake depends on. Samples follow directly, so the header size
+// keeps them 16-byte aligned in the mapping.
+struct VolumeHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t resolution;
+    int32_t iterations;
+    float halfSize;
+    float mandelboxScale;
+    float minRadius;
+    float fixedRadius;
+    uint32_t flags;
+    uint32_t reserved[3];
+};
+
+static_assert(sizeof(VolumeHeader) == 48, "VolumeHeader must stay packed");
+
+static VolumeHeader makeHeader(int resolution, int iterations, bool symmetric) {
+    VolumeHeader header;
+    std::memcpy(header.magic, VOLUME_MAGIC, sizeof(header.magic));
+    header.version = VOLUME_VERSION;
+    header.resolution = resolution;
+    header.iterations = iterations;
+    header.halfSize = BOUNDS_HALF_SIZE;
+    header.mandelboxScale = MANDELBOX_SCALE;
+    header.minRadius = MANDELBOX_MIN_RADIUS;
+    header.fixedRadius = MANDELBOX_FIXED_RADIUS;
+    header.flags = symmetric ? VOLUME_SYMMETRIC : 0;
+    std::memset(header.reserved, 0, sizeof(header.reserved));
+    return header;
+}
+
+DistanceVolume::~DistanceVolume() {
+    release();
+}
+
+void DistanceVolume::release() {
+#ifndef _WIN32
+    if (mapping)
+        munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    baked.clear();
+    baked.shrink_to_fit();
+    samples = nullptr;
+    size = 0;
+    count = 0;
+    folded = false;
+}
+
+float DistanceVolume::cellSize() const {
+    return 2.0f * BOUNDS_HALF_SIZE / static_cast<float>(size - 1);
+}
+
+size_t DistanceVolume::wedgeIndex(int i, int j, int k) {
+    return static_cast<size_t>(i) * (i + 1) * (i + 2) / 6 + static_cast<size_t>(j) * (j + 1) / 2 + k;
+}
+
+static size_t sampleCountFor(int resolution, bool symmetric) {
+    if (symmetric)
+        return DistanceVolume::wedgeIndex(resolution / 2 + 1, 0, 0);
+    return static_cast<size_t>(resolution) * resolution * resolution;
+}
+
+size_t DistanceVolume::sampleCount() const {
+    return sampleCountFor(size, folded);
+}
+
+void DistanceVolume::bake(int resolution, int iterations, ThreadPool& pool, bool symmetric) {
+    release();
+    size = symmetric ? resolution | 1 : resolution;
+    count = iterations;
+    folded = symmetric;
+    baked.resize(sampleCount());
+
+    // Every point is within half a cell diagonal of its nearest sample.
+    const float cell = cellSize();
+    const float reach = 0.5f * cell * std::sqrt(3.0f);
+
+    if (symmetric) {
+        // One task per (i, j) column of the wedge, k running up to j.
+        const int half = halfResolution();
+        pool.parallelFor(wedgeIndex(0, half, 0), [&](size_t column) {
+            int i = 0;
+            while (wedgeIndex(0, i + 1, 0) <= column)
+                i++;
+            int j = static_cast<int>(column - wedgeIndex(0, i, 0));
+            float* out = &baked[wedgeIndex(i, j, 0)];
+            for (int k = 0; k <= j; k++)
+                out[k] = mandelboxDEMin(glm::vec3(i, j, k) * cell, iterations) - reach;
+        });
+        samples = baked.data();
+        return;
+    }
+
+    pool.parallelFor(static_cast<size_t>(resolution) * resolution, [&](size_t row) {
+        int y = static_cast<int>(row % resolution);
+        int z = static_cast<int>(row / resolution);
+        float* out = &baked[row * resolution];
+        for (int x = 0; x < resolution; x++) {
+            glm::vec3 p = glm::vec3(x, y, z) * cell - BOUNDS_HALF_SIZE;
+            out[x] = mandelboxDEMin(p, iterations) - reach;
+        }
+    });
+
+    samples = baked.data();
+}
+
+bool DistanceVolume::save(const std::string& path) const {
+    if (empty())
+        return false;
+
+    // Write to a temporary name first so a concurrent start never maps half a file.
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "ERROR::VOLUME::CACHE_NOT_WRITABLE: " << tempPath << std::endl;
+            return false;
+        }
+        VolumeHeader header = makeHeader(size, count, folded);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(samples),
+                   static_cast<std::streamsize>(sizeof(float) * sampleCount()));
+        if (!file)
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    return !error;
+}
+
+bool DistanceVolume::map(const std::string& path) {
+    release();
+
+#ifdef _WIN32
+    // No mmap here; read the samples into memory instead.
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    VolumeHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
+    bool symmetric = header.flags == VOLUME_SYMMETRIC;
+    VolumeHeader expected = makeHeader(header.resolution, header.iterations, symmetric);
+    if (std::memcmp(&header, &expected, sizeof(header)) != 0 || header.resolution < 2)
+        return false;
+    baked.resize(sampleCountFor(header.resolution, symmetric));
+    if (!file.read(reinterpret_cast<char*>(baked.data()), sizeof(float) * baked.size())) {
+        baked.clear();
+        return false;
+    }
+    samples = baked.data();
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(VolumeHeader))
+        data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    mapping = data;
+    mappingSize = static_cast<size_t>(info.st_size);
+
+    VolumeHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    bool symmetric = header.flags == VOLUME_SYMMETRIC;
+    VolumeHeader expected = makeHeader(header.resolution, header.iterations, symmetric);
+    if (std::memcmp(&header, &expected, sizeof(header)) != 0 || header.resolution < 2 ||
+        mappingSize != sizeof(header) + sizeof(float) * sampleCountFor(header.resolution, symmetric)) {
+        release();
+        return false;
+    }
+    samples = reinterpret_cast<const float*>(static_cast<const char*>(data) + sizeof(header));
+#endif
+
+    size = header.resolution;
+    count = header.iterations;
+    folded = symmetric;
+    return true;
+}
+
+bool DistanceVolume::load(const std::string& directory, int resolution, int iterations, ThreadPool& pool,
+                          bool symmetric) {
+    if (resolution < 2 || iterations < 1)
+        return false;
+    if (symmetric)
+        resolution |= 1;
+
+    std::string path;
+    if (!directory.empty()) {
+        path = directory + "/" + cacheFileName(resolution, iterations, symmetric);
+        if (map(path) && size == resolution && count == iterations && folded == symmetric)
+            return true;
+    }
+
+    std::cout << "Baking " << resolution << "^3 " << (symmetric ? "symmetric " : "") << "distance volume at "
+              << iterations << " iterations..." << std::endl;
+    bake(resolution, iterations, pool, symmetric);
+    if (path.empty())
+        return true;
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    // Map the saved copy so this session shares pages with later ones; the
+    // in-memory bake is kept if the cache is not writable.
+    if (save(path)) {
+        DistanceVolume mapped;
+        if (mapped.map(path) && mapped.size == resolution && mapped.count == iterations &&
+            mapped.folded == symmetric) {
+            release();
+            std::swap(mapping, mapped.mapping);
+            std::swap(mappingSize, mapped.mappingSize);
+            std::swap(samples, mapped.samples);
+            size = resolution;
+            count = iterations;
+            folded = symmetric;
+        }
+    }
+    return true;
+}
+
+std::string DistanceVolume::defaultDirectory() {
+    if (const char* path = std::getenv("FRACTAL_VOLUME_CACHE"))
+        return path;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"))
+        return std::string(xdg) + "/fractal";
+    if (const char* home = std::getenv("HOME"))
+        return std::string(home) + "/.cache/fractal";
+    return "volume_cache";
+}
+
+// FNV-1a over the header, so a change to the Mandelbox constants or the file
+// layout never picks up a stale bake.
+std::string DistanceVolume::cacheFileName(int resolution, int iterations, bool symmetric) {
+    VolumeHeader header = makeHeader(resolution, iterations, symmetric);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&header);
+
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < sizeof(header); i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    char name[40];
+    std::snprintf(name, sizeof(name), "volume_%016llx.bin", static_cast<unsigned long long>(hash));
+    return name;
+}
+
+float DistanceVolume::lowerBound(const glm::vec3& objPos) const {
+    glm::vec3 q = glm::clamp(objPos, -BOUNDS_HALF_SIZE, BOUNDS_HALF_SIZE);
+    if (folded) {
+        // Rounding keeps the fold's ordering, so the sample is in the wedge.
+        glm::vec3 f = glm::floor(symmetryFold(q) / cellSize() + 0.5f);
+        glm::ivec3 i = glm::min(glm::ivec3(f), glm::ivec3(halfResolution() - 1));
+        return samples[wedgeIndex(i.x, i.y, i.z)] - glm::length(objPos - q);
+    }
+
+    glm::vec3 g = glm::floor((q + BOUNDS_HALF_SIZE) / cellSize() + 0.5f);
+    glm::ivec3 i = glm::clamp(glm::ivec3(g), glm::ivec3(0), glm::ivec3(size - 1));
+
+    size_t index = (static_cast<size_t>(i.z) * size + i.y) * size + i.x;
+    return samples[index] - glm::length(objPos - q);
+}
@@ -0,0 +1,287 @@
+#include "fractal.h"
+#include "distance_bound.h"
+#include <algorithm>
+#include <cmath>
+
+// One fold iteration; z and dr carry the orbit.
+static inline void foldIteration(glm::vec3& z, float& dr, const glm::vec3& pos) {
+    const float scale = MANDELBOX_SCALE;
+    const float minRadius = MANDELBOX_MIN_RADIUS;
+    const float fixedRadius = MANDELBOX_FIXED_RADIUS;
+
+    z = glm::clamp(z, -1.0f, 1.0f) * 2.0f - z;
+
+    float r2 = glm::dot(z, z);
+
+    if (r2 < minRadius * minRadius) {
+        float t = (fixedRadius * fixedRadius) / (minRadius * minRadius);
+        z *= t;
+        dr *= t;
+    } else if (r2 < fixedRadius * fixedRadius) {
+        float t = (fixedRadius * fixedRadius) / r2;
+        z *= t;
+        dr *= t;
+    }
+
+    z = z * scale + pos;
+    dr = dr * std::abs(scale) + 1.0f;
+}
+
+float mandelboxDE(const glm::vec3& pos, float iterations, float& orbitTrap) {
+    glm::vec3 z = pos;
+    float dr = 1.0f;
+
+    orbitTrap = 1000.0f;
+
+    // Estimate and trap after the last whole iteration, for a fractional
+    // count.
+    float lower = -1.0f;
+    float lowerTrap = 1000.0f;
+    float blend = 0.0f;
+
+    for (int i = 0; static_cast<float>(i) < iterations; i++) {
+        if (static_cast<float>(i + 1) > iterations) {
+            lower = glm::length(z) / std::abs(dr);
+            lowerTrap = orbitTrap;
+            blend = iterations - static_cast<float>(i);
+        }
+
+        foldIteration(z, dr, pos);
+
+        orbitTrap = std::min(orbitTrap,
+                             std::abs(z.x) + std::abs(z.y) + std::abs(z.z));
+
+        if (glm::dot(z, z) > ESCAPE_RADIUS2) {
+            break;
+        }
+    }
+
+    float de = glm::length(z) / std::abs(dr);
+    if (lower < 0.0f)
+        return de;
+    orbitTrap = lowerTrap * (1.0f - blend) + orbitTrap * blend;
+    return lower * (1.0f - blend) + de * blend;
+}
+
+float mandelboxDEMin(const glm::vec3& pos, int maxIterations) {
+    glm::vec3 z = pos;
+    float dr = 1.0f;
+    float result = 1e9f;
+
+    for (int i = 0; i < maxIterations; i++) {
+        foldIteration(z, dr, pos);
+        result = std::min(result, glm::length(z) / std::abs(dr));
+
+        if (glm::dot(z, z) > ESCAPE_RADIUS2) {
+            break;
+        }
+    }
+
+    return result;
+}
+
+glm::vec3 toObjectSpace(const glm::vec3& p, const FractalParams& params) {
+    glm::vec3 objPos = p / params.scale;
+
+    if (params.autoRotate) {
+        float angle = params.time * 0.1f;
+        float s = std::sin(angle);
+        float c = std::cos(angle);
+        glm::mat3 rotY(
+            c, 0.0f, s,
+            0.0f, 1.0f, 0.0f,
+            -s, 0.0f, c
+        );
+        objPos = rotY * objPos;
+    }
+
+    return objPos;
+}
+
+glm::vec3 primaryRayDir(const ViewParams& view, const glm::vec2& texCoord) {
+    float tanHalfFov = std::tan(view.fov / 2.0f);
+    glm::vec2 uv = (texCoord * 2.0f - 1.0f) *
+                   glm::vec2(static_cast<float>(view.width) / static_cast<float>(view.height), 1.0f);
+
+    return glm::normalize(
+        view.camFront +
+        view.camRight * uv.x * tanHalfFov +
+        view.camUp * uv.y * tanHalfFov
+    );
+}
+
+float pixelCone(const ViewParams& view) {
+    return 2.0f * std::tan(view.fov / 2.0f) / static_cast<float>(view.height);
+}
+
+float hitEpsilon(float depth, float pixelCone, const FractalParams& params) {
+    return std::max(MIN_DIST * params.scale, depth * (pixelCone * HIT_FOOTPRINT));
+}
+
+float farLimit(const FractalParams& params) {
+    return MAX_DIST * params.scale;
+}
+
+glm::vec3 symmetryFold(const glm::vec3& p) {
+    glm::vec3 f = glm::abs(p);
+    if (f.x < f.y)
+        std::swap(f.x, f.y);
+    if (f.y < f.z)
+        std::swap(f.y, f.z);
+    if (f.x < f.y)
+        std::swap(f.x, f.y);
+    return f;
+}
+
+// toObjectSpace() is linear, so it maps the ray to an object-space ray with
+// the same parameter: depths along it stay world-space.
+bool boundsInterval(const glm::vec3& ro, const glm::vec3& rd, const FractalParams& params,
+                    float pixelCone, float& entry, float& exit) {
+    glm::vec3 o = toObjectSpace(ro, params);
+    glm::vec3 d = toObjectSpace(rd, params);
+    float halfSize = BOUNDS_HALF_SIZE + hitEpsilon(farLimit(params), pixelCone, params) / params.scale;
+
+    glm::vec3 inv = 1.0f / d;
+    glm::vec3 t0 = (-halfSize - o) * inv;
+    glm::vec3 t1 = (halfSize - o) * inv;
+    glm::vec3 tMin = glm::min(t0, t1);
+    glm::vec3 tMax = glm::max(t0, t1);
+
+    entry = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+    exit = std::min(std::min(tMax.x, tMax.y), tMax.z);
+    return entry < exit;
+}
+
+// Volume steps stop within a cell of the surface, where the exact estimate
+// takes over. They start at the entry rather than at startDepth: stepping on
+// from the prepass depth lands nearer the surface than the exact march from
+// there, whose last samples, orbit trap and shading would then differ.
+bool marchInterval(const glm::vec3& ro, const glm::vec3& rd, const FractalParams& params,
+                   const MarchSettings& settings, float startDepth, float& start, float& limit) {
+    float entry, exit;
+    if (!boundsInterval(ro, rd, params, settings.pixelCone, entry, exit))
+        return false;
+    start = entry;
+    limit = std::min(farLimit(params), exit);
+
+    if (settings.volume && settings.volume->covers(params)) {
+        const float minStep = settings.volume->minStep() * params.scale;
+        for (int i = 0; i < MAX_STEPS && start < limit; i++) {
+            float step = settings.volume->lowerBound(toObjectSpace(ro + rd * start, params)) * params.scale;
+            if (step < minStep)
+                break;
+            start += step;
+        }
+    }
+    start = std::max(start, startDepth);
+    return start < limit;
+}
+
+float iterationLod(float epsilon, const FractalParams& params) {
+    float n = std::log2(LOD_DETAIL * params.scale / epsilon) / std::log2(std::abs(MANDELBOX_SCALE));
+    return std::min(std::max(n, 1.0f), static_cast<float>(params.maxIterations));
+}
+
+float sceneSDF(const glm::vec3& p, const FractalParams& params, float iterations, float& orbitTrap) {
+    glm::vec3 objPos = toObjectSpace(p, params);
+    return mandelboxDE(objPos, iterations, orbitTrap) * params.scale;
+}
+
+float sceneSDF(const glm::vec3& p, const FractalParams& params, float& orbitTrap) {
+    return sceneSDF(p, params, static_cast<float>(params.maxIterations), orbitTrap);
+}
+
+// Over-relaxation follows Keinert et al., "Enhanced Sphere Tracing": a
+// stretched step is only safe if the sphere around the new point reaches back
+// to the previous one. When it does not, the ray returns to the previous
+// point, takes the plain step and stays unrelaxed. A relaxed hit is refined
+// by bisection between the last two depths. Every estimate runs only the
+// fold iterations its hit epsilon can resolve, and only the stretch of the
+// ray marchInterval() leaves is marched.
+MarchResult rayMarch(const glm::vec3& ro, const glm::vec3& rd, const FractalParams& params,
+                     const MarchSettings& settings, float startDepth, float startTrap) {
+    const float maxDist = farLimit(params);
+
+    MarchResult result;
+    result.depth = maxDist;
+    result.steps = 0;
+    result.hit = false;
+    result.orbitTrap = startTrap;
+    result.evaluations = 0;
+
+    float depth, marchLimit;
+    if (!marchInterval(ro, rd, params, settings, startDepth, depth, marchLimit))
+        return result;
+
+    float previousDepth = depth;
+    float previousDist = 0.0f;
+    float omega = std::max(settings.relaxation, 1.0f);
+
+    for (int i = 0; i < MAX_STEPS; i++) {
+        result.steps = i;
+        glm::vec3 p = ro + rd * depth;
+        float epsilon = hitEpsilon(depth, settings.pixelCone, params);
+        float trap;
+        float dist = sceneSDF(p, params, iterationLod(epsilon, params), trap);
+        result.evaluations++;
+
+        if (omega > 1.0f && dist + previousDist < depth - previousDepth) {
+            depth = previousDepth + previousDist;
+            omega = 1.0f;
+            continue;
+        }
+
+        result.orbitTrap = std::min(result.orbitTrap, trap);
+
+        if (dist < epsilon) {
+            if (omega > 1.0f) {
+                float lo = previousDepth;
+                float hi = depth;
+                for (int b = 0; b < BISECTION_STEPS; b++) {
+                    float mid = (lo + hi) * 0.5f;
+                    float midEpsilon = hitEpsilon(mid, settings.pixelCone, params);
+                    float midTrap;
+                    if (sceneSDF(ro + rd * mid, params, iterationLod(midEpsilon, params), midTrap) < midEpsilon)
+                        hi = mid;
+                    else
+                        lo = mid;
+                }
+                result.evaluations += BISECTION_STEPS;
+                depth = hi;
+            }
+            result.hit = true;
+            result.depth = depth;
+            return result;
+        }
+
+        previousDepth = depth;
+        previousDist = dist;
+        depth += dist * omega;
+
+        if (depth >= marchLimit) {
+            break;
+        }
+    }
+
+    return result;
+}
+
+void mandelboxDEBatch(const glm::vec3* points, size_t count, int maxIterations,
+                      float* distances, float* orbitTraps) {
+    for (size_t i = 0; i < count; i++) {
+        float trap;
+        distances[i] = mandelboxDE(points[i], static_cast<float>(maxIterations), trap);
+        if (orbitTraps)
+            orbitTraps[i] = trap;
+    }
+}
+
+void sceneSDFBatch(const glm::vec3* points, size_t count, const FractalParams& params,
+                   float* distances, float* orbitTraps) {
+    for (size_t i = 0; i < count; i++) {
+        float trap;
+        distances[i] = sceneSDF(points[i], params, trap);
+        if (orbitTraps)
+            orbitTraps[i] = trap;
+    }
+}
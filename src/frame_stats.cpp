@@ -0,0 +1,170 @@
+#include "frame_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+FrameTimeSummary summarizeFrameTimes(std::vector<double> frameMs) {
+    FrameTimeSummary summary;
+    if (frameMs.empty())
+        return summary;
+
+    std::sort(frameMs.begin(), frameMs.end());
+
+    double total = 0.0;
+    for (double ms : frameMs)
+        total += ms;
+
+    summary.count = frameMs.size();
+    summary.minMs = frameMs.front();
+    summary.maxMs = frameMs.back();
+    summary.meanMs = total / frameMs.size();
+    summary.p50Ms = percentile(frameMs, 50.0);
+    summary.p95Ms = percentile(frameMs, 95.0);
+    summary.p99Ms = percentile(frameMs, 99.0);
+    summary.fps = total > 0.0 ? 1000.0 * frameMs.size() / total : 0.0;
+    return summary;
+}
+
+FrameStatsRecorder::FrameStatsRecorder(double reportInterval)
+    : interval(reportInterval) {
+    reporter = std::thread(&FrameStatsRecorder::run, this);
+}
+
+FrameStatsRecorder::~FrameStatsRecorder() {
+    stop();
+}
+
+void FrameStatsRecorder::record(const FrameSample& sample) {
+    if (!ring.push(sample))
+        dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameStatsRecorder::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping)
+            return;
+        stopping = true;
+    }
+    wake.notify_all();
+    reporter.join();
+}
+
+void FrameStatsRecorder::drain() {
+    FrameSample sample;
+    while (ring.pop(sample)) {
+        // File the late GPU result under the frame it measured.
+        if (sample.gpuFrame >= 0) {
+            for (size_t i = history.size(); i > 0; i--) {
+                if (history[i - 1].frame == sample.gpuFrame) {
+                    history[i - 1].gpuMs = sample.gpuMs;
+                    break;
+                }
+                if (history[i - 1].frame < sample.gpuFrame)
+                    break;
+            }
+        }
+
+        if (sample.frame < 0)
+            continue;
+
+        sample.gpuFrame = -1;
+        sample.gpuMs = -1.0;
+        history.push_back(sample);
+    }
+}
+
+void FrameStatsRecorder::report() {
+    if (windowStart >= history.size())
+        return;
+
+    std::vector<double> frameMs, gpuMs;
+    for (size_t i = windowStart; i < history.size(); i++) {
+        frameMs.push_back(history[i].frameMs);
+        if (history[i].gpuMs >= 0.0)
+            gpuMs.push_back(history[i].gpuMs);
+    }
+
+    FrameTimeSummary frames = summarizeFrameTimes(frameMs);
+    FrameTimeSummary gpu = summarizeFrameTimes(gpuMs);
+
+    size_t stutters = 0;
+    for (double ms : frameMs) {
+        if (ms > 2.0 * frames.p50Ms)
+            stutters++;
+    }
+
+    const FrameSample& last = history.back();
+    std::printf("\rFPS: %.0f | Frame p50/p95/p99: %.2f/%.2f/%.2f ms | GPU p50: %.2f ms | Stutters: %zu"
+                " | Resolution: %.0f%% | Zoom Level: 2^%d | Max Iterations: %d | Speed: %g   ",
+                frames.fps, frames.p50Ms, frames.p95Ms, frames.p99Ms, gpu.p50Ms, stutters,
+                last.renderScale * 100.0f, last.exponent, last.maxIterations, last.speed);
+    std::fflush(stdout);
+
+    windowStart = history.size();
+}
+
+void FrameStatsRecorder::run() {
+    using Clock = std::chrono::steady_clock;
+    auto nextReport = Clock::now() + std::chrono::duration<double>(interval);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        wake.wait_for(lock, std::chrono::milliseconds(50));
+
+        drain();
+        if (interval > 0.0 && Clock::now() >= nextReport) {
+            report();
+            nextReport = Clock::now() + std::chrono::duration<double>(interval);
+        }
+    }
+    drain();
+
+    if (interval > 0.0)
+        std::printf("\n");
+    size_t lost = dropped.load();
+    if (lost > 0)
+        std::printf("Frame stats: %zu samples dropped\n", lost);
+}
+
+bool FrameStatsRecorder::dump(const std::string& filePath) const {
+    FILE* file = std::fopen(filePath.c_str(), "w");
+    if (!file) {
+        std::fprintf(stderr, "ERROR::STATS::FILE_NOT_SUCCESSFULLY_WRITTEN: %s\n", filePath.c_str());
+        return false;
+    }
+
+    bool json = filePath.size() >= 5 && filePath.compare(filePath.size() - 5, 5, ".json") == 0;
+    if (json) {
+        std::fprintf(file, "[\n");
+        for (size_t i = 0; i < history.size(); i++) {
+            const FrameSample& s = history[i];
+            std::fprintf(file,
+                         "  {\"frame\": %lld, \"frameMs\": %.4f, \"cpuMs\": %.4f, \"gpuMs\": %.4f, \"swapMs\": %.4f, "
+                         "\"mantissa\": [%.9g, %.9g, %.9g], \"exponent\": %d, \"maxIterations\": %d, "
+                         "\"time\": %.6f, \"speed\": %g, \"renderScale\": %.4f}%s\n",
+                         s.frame, s.frameMs, s.cpuMs, s.gpuMs, s.swapMs,
+                         s.mantissa.x, s.mantissa.y, s.mantissa.z, s.exponent, s.maxIterations,
+                         s.time, s.speed, s.renderScale, i + 1 < history.size() ? "," : "");
+        }
+        std::fprintf(file, "]\n");
+    } else {
+        std::fprintf(file, "frame,frame_ms,cpu_ms,gpu_ms,swap_ms,mantissa_x,mantissa_y,mantissa_z,exponent,max_iterations,time,speed,render_scale\n");
+        for (const FrameSample& s : history) {
+            std::fprintf(file, "%lld,%.4f,%.4f,%.4f,%.4f,%.9g,%.9g,%.9g,%d,%d,%.6f,%g,%.4f\n",
+                         s.frame, s.frameMs, s.cpuMs, s.gpuMs, s.swapMs,
+                         s.mantissa.x, s.mantissa.y, s.mantissa.z, s.exponent, s.maxIterations,
+                         s.time, s.speed, s.renderScale);
+        }
+    }
+
+    bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
@@ -0,0 +1,90 @@
+#include "gpu_timer.h"
+
+GpuTimer::GpuTimer(int latency) : slots(latency < 2 ? 2 : latency) {
+}
+
+GpuTimer::~GpuTimer() {
+    for (Slot& slot : slots) {
+        if (slot.frameStart) {
+            glDeleteQueries(1, &slot.frameStart);
+            glDeleteQueries(1, &slot.frameEnd);
+        }
+        if (!slot.stageQueries.empty())
+            glDeleteQueries(static_cast<GLsizei>(slot.stageQueries.size()), slot.stageQueries.data());
+    }
+}
+
+int GpuTimer::addStage(const std::string& name) {
+    stages.push_back(name);
+    lastStageMs.push_back(-1.0);
+    return static_cast<int>(stages.size()) - 1;
+}
+
+void GpuTimer::createQueries() {
+    for (Slot& slot : slots) {
+        glGenQueries(1, &slot.frameStart);
+        glGenQueries(1, &slot.frameEnd);
+        slot.stageQueries.resize(stages.size());
+        slot.stageIssued.assign(stages.size(), false);
+        if (!stages.empty())
+            glGenQueries(static_cast<GLsizei>(stages.size()), slot.stageQueries.data());
+    }
+}
+
+bool GpuTimer::collect(Slot& slot) {
+    GLint available = 0;
+    glGetQueryObjectiv(slot.frameEnd, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    GLuint64 start = 0, end = 0;
+    glGetQueryObjectui64v(slot.frameStart, GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(slot.frameEnd, GL_QUERY_RESULT, &end);
+    lastFrameMs = static_cast<double>(end - start) / 1.0e6;
+    lastFrameNumber = slot.frameNumber;
+
+    // Stages were submitted before frameEnd, so they are complete as well.
+    // A stage cannot outlast its frame; Mesa llvmpipe reports garbage for the
+    // very first TIME_ELAPSED query, so such results are discarded.
+    for (size_t i = 0; i < stages.size(); i++) {
+        if (!slot.stageIssued[i])
+            continue;
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(slot.stageQueries[i], GL_QUERY_RESULT, &elapsed);
+        if (elapsed <= end - start)
+            lastStageMs[i] = static_cast<double>(elapsed) / 1.0e6;
+    }
+    return true;
+}
+
+bool GpuTimer::beginFrame() {
+    if (current < 0)
+        createQueries();
+
+    current = (current + 1) % static_cast<int>(slots.size());
+    Slot& slot = slots[current];
+
+    // If the GPU is more than a ring behind, drop that sample rather than wait.
+    bool collected = slot.issued && collect(slot);
+
+    slot.issued = false;
+    slot.stageIssued.assign(stages.size(), false);
+    slot.frameNumber = frameCounter++;
+    glQueryCounter(slot.frameStart, GL_TIMESTAMP);
+    return collected;
+}
+
+void GpuTimer::endFrame() {
+    Slot& slot = slots[current];
+    glQueryCounter(slot.frameEnd, GL_TIMESTAMP);
+    slot.issued = true;
+}
+
+void GpuTimer::beginStage(int stage) {
+    glBeginQuery(GL_TIME_ELAPSED, slots[current].stageQueries[stage]);
+}
+
+void GpuTimer::endStage(int stage) {
+    glEndQuery(GL_TIME_ELAPSED);
+    slots[current].stageIssued[stage] = true;
+}
@@ -0,0 +1,70 @@
+#include "image_io.h"
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+
+static bool hasExtension(const std::string& path, const std::string& ext) {
+    if (path.size() < ext.size())
+        return false;
+
+    for (size_t i = 0; i < ext.size(); i++) {
+        char c = path[path.size() - ext.size() + i];
+        if (c >= 'A' && c <= 'Z')
+            c = static_cast<char>(c - 'A' + 'a');
+        if (c != ext[i])
+            return false;
+    }
+    return true;
+}
+
+bool writeImage(const std::string& filePath, int width, int height,
+                const std::vector<glm::vec3>& pixels) {
+    if (hasExtension(filePath, ".pfm"))
+        return writePFM(filePath, width, height, pixels);
+    return writePPM(filePath, width, height, pixels);
+}
+
+bool writePPM(const std::string& filePath, int width, int height,
+              const std::vector<glm::vec3>& pixels) {
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file) {
+        std::cerr << "ERROR::IMAGE::FILE_NOT_SUCCESSFULLY_WRITTEN: " << filePath << std::endl;
+        return false;
+    }
+
+    file << "P6\n" << width << " " << height << "\n255\n";
+
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            glm::vec3 c = glm::clamp(pixels[static_cast<size_t>(y) * width + x], 0.0f, 1.0f);
+            row[x * 3 + 0] = static_cast<uint8_t>(c.r * 255.0f + 0.5f);
+            row[x * 3 + 1] = static_cast<uint8_t>(c.g * 255.0f + 0.5f);
+            row[x * 3 + 2] = static_cast<uint8_t>(c.b * 255.0f + 0.5f);
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+
+    return static_cast<bool>(file);
+}
+
+bool writePFM(const std::string& filePath, int width, int height,
+              const std::vector<glm::vec3>& pixels) {
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file) {
+        std::cerr << "ERROR::IMAGE::FILE_NOT_SUCCESSFULLY_WRITTEN: " << filePath << std::endl;
+        return false;
+    }
+
+    // Negative scale marks little-endian data; PFM stores rows bottom to top.
+    const uint16_t probe = 1;
+    bool littleEndian = *reinterpret_cast<const uint8_t*>(&probe) == 1;
+    file << "PF\n" << width << " " << height << "\n" << (littleEndian ? "-1.0" : "1.0") << "\n";
+
+    for (int y = height - 1; y >= 0; y--) {
+        file.write(reinterpret_cast<const char*>(&pixels[static_cast<size_t>(y) * width]),
+                   static_cast<std::streamsize>(width) * sizeof(glm::vec3));
+    }
+
+    return static_cast<bool>(file);
+}
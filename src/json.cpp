@@ -0,0 +1,247 @@
+#include "json.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+const JsonValue* JsonValue::find(const std::string& key) const {
+    if (type != Object)
+        return nullptr;
+
+    for (const auto& member : object) {
+        if (member.first == key)
+            return &member.second;
+    }
+    return nullptr;
+}
+
+namespace {
+
+class JsonParser {
+public:
+    JsonParser(const std::string& text) : text(text) {}
+
+    bool parseDocument(JsonValue& out, std::string& error) {
+        skipSpace();
+        if (!parseValue(out, 0)) {
+            error = message;
+            return false;
+        }
+        skipSpace();
+        if (pos != text.size()) {
+            fail("unexpected trailing characters");
+            error = message;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    const std::string& text;
+    size_t pos = 0;
+    std::string message;
+
+    bool fail(const char* what) {
+        if (message.empty()) {
+            size_t line = 1;
+            for (size_t i = 0; i < pos && i < text.size(); i++) {
+                if (text[i] == '\n')
+                    line++;
+            }
+            message = std::string(what) + " at line " + std::to_string(line);
+        }
+        return false;
+    }
+
+    void skipSpace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' ||
+                                     text[pos] == '\n' || text[pos] == '\r'))
+            pos++;
+    }
+
+    bool match(const char* word) {
+        size_t len = std::char_traits<char>::length(word);
+        if (text.compare(pos, len, word) != 0)
+            return false;
+        pos += len;
+        return true;
+    }
+
+    bool parseValue(JsonValue& out, int depth) {
+        if (depth > 64)
+            return fail("nesting too deep");
+        if (pos >= text.size())
+            return fail("unexpected end of input");
+
+        char c = text[pos];
+        if (c == '{')
+            return parseObject(out, depth);
+        if (c == '[')
+            return parseArray(out, depth);
+        if (c == '"') {
+            out.type = JsonValue::String;
+            return parseString(out.string);
+        }
+        if (match("true")) {
+            out.type = JsonValue::Bool;
+            out.boolean = true;
+            return true;
+        }
+        if (match("false")) {
+            out.type = JsonValue::Bool;
+            out.boolean = false;
+            return true;
+        }
+        if (match("null")) {
+            out.type = JsonValue::Null;
+            return true;
+        }
+        return parseNumber(out);
+    }
+
+    bool parseNumber(JsonValue& out) {
+        const char* begin = text.c_str() + pos;
+        char* end = nullptr;
+        double value = std::strtod(begin, &end);
+        if (end == begin)
+            return fail("invalid value");
+
+        pos += static_cast<size_t>(end - begin);
+        out.type = JsonValue::Number;
+        out.number = value;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        pos++;
+        out.clear();
+        while (pos < text.size()) {
+            char c = text[pos++];
+            if (c == '"')
+                return true;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= text.size())
+                break;
+
+            char esc = text[pos++];
+            switch (esc) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                if (pos + 4 > text.size())
+                    return fail("truncated escape");
+                unsigned code = static_cast<unsigned>(std::strtoul(text.substr(pos, 4).c_str(), nullptr, 16));
+                pos += 4;
+                if (code < 0x80) {
+                    out += static_cast<char>(code);
+                } else if (code < 0x800) {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default:
+                return fail("invalid escape");
+            }
+        }
+        return fail("unterminated string");
+    }
+
+    bool parseArray(JsonValue& out, int depth) {
+        pos++;
+        out.type = JsonValue::Array;
+        skipSpace();
+        if (pos < text.size() && text[pos] == ']') {
+            pos++;
+            return true;
+        }
+
+        while (true) {
+            out.array.emplace_back();
+            skipSpace();
+            if (!parseValue(out.array.back(), depth + 1))
+                return false;
+            skipSpace();
+            if (pos < text.size() && text[pos] == ',') {
+                pos++;
+                continue;
+            }
+            if (pos < text.size() && text[pos] == ']') {
+                pos++;
+                return true;
+            }
+            return fail("expected ',' or ']'");
+        }
+    }
+
+    bool parseObject(JsonValue& out, int depth) {
+        pos++;
+        out.type = JsonValue::Object;
+        skipSpace();
+        if (pos < text.size() && text[pos] == '}') {
+            pos++;
+            return true;
+        }
+
+        while (true) {
+            skipSpace();
+            if (pos >= text.size() || text[pos] != '"')
+                return fail("expected member name");
+
+            std::string key;
+            if (!parseString(key))
+                return false;
+            skipSpace();
+            if (pos >= text.size() || text[pos] != ':')
+                return fail("expected ':'");
+            pos++;
+            skipSpace();
+
+            out.object.emplace_back(key, JsonValue());
+            if (!parseValue(out.object.back().second, depth + 1))
+                return false;
+            skipSpace();
+            if (pos < text.size() && text[pos] == ',') {
+                pos++;
+                continue;
+            }
+            if (pos < text.size() && text[pos] == '}') {
+                pos++;
+                return true;
+            }
+            return fail("expected ',' or '}'");
+        }
+    }
+};
+
+}
+
+bool parseJson(const std::string& text, JsonValue& out, std::string& error) {
+    out = JsonValue();
+    JsonParser parser(text);
+    return parser.parseDocument(out, error);
+}
+
+bool readJsonFile(const char* filePath, JsonValue& out, std::string& error) {
+    std::ifstream file(filePath);
+    if (!file) {
+        error = std::string("cannot open ") + filePath;
+        return false;
+    }
+
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return parseJson(stream.str(), out, error);
+}
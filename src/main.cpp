@@ -4,24 +4,49 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include "shader.h"
+#include "brick_map.h"
 #include "camera.h"
-
+#include "camera_script.h"
+#include "distance_clipmap.h"
+#include "distance_volume.h"
+#include "frame_stats.h"
+#include "gpu_timer.h"
+#include "render_target.h"
+#include "resolution_controller.h"
+#include "shader_renderer.h"
+#include "shader_watcher.h"
+
+#include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 void mouseCallback(GLFWwindow* window, double xpos, double ypos);
 void scrollCallback(GLFWwindow* window, double xoffset, double yoffset);
+void refreshCallback(GLFWwindow* window);
 void processInput(GLFWwindow* window);
+ViewParams currentView(int width, int height, float time);
+void updateClipmap(ShaderRenderer& renderer, const ViewParams& view);
+int runBenchmark(GLFWwindow* window, ShaderRenderer& renderer, const CameraScript& script,
+                 FrameStatsRecorder& stats);
 
 const unsigned int SCR_WIDTH = 960;
 const unsigned int SCR_HEIGHT = 540;
 
+// Longest sleep while nothing needs drawing; bounds how late shader edits are
+// noticed. Out of focus, frames are spaced at least UNFOCUSED_FRAME apart.
+const double IDLE_WAIT = 0.25;
+const double UNFOCUSED_FRAME = 0.1;
+
 Camera camera(glm::vec3(0.0f, 0.0f, 5.0f));
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
+bool redrawRequested = false;
 
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
@@ -29,10 +54,58 @@ float lastFrame = 0.0f;
 int maxIterations = 16;
 bool autoRotate = false;
 
+// Camera-centred distance cache, topped up by at most CLIPMAP_BUDGET samples
+// a frame so flying never stalls on it.
+const size_t CLIPMAP_BUDGET = 16384;
+std::unique_ptr<DistanceClipmap> clipmap;
+std::unique_ptr<ThreadPool> clipmapPool;
+
 glm::vec3 cameraMantissa = glm::vec3(0.0f, 0.0f, 5.0f);
 int cameraExponent = -2;
 
-int main() {
+int main(int argc, char** argv) {
+    const char* benchmarkPath = nullptr;
+    const char* statsPath = nullptr;
+    double statsInterval = 1.0;
+    float temporalFraction = 0.0f;
+    double resolutionTarget = 16.0;
+    int accumulationSamples = 64;
+    int volumeResolution = 0;
+    int brickResolution = 0;
+    int clipmapSize = 0;
+    bool symmetric = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+            benchmarkPath = argv[++i];
+        else if (std::strcmp(argv[i], "--stats-out") == 0 && i + 1 < argc)
+            statsPath = argv[++i];
+        else if (std::strcmp(argv[i], "--stats-interval") == 0 && i + 1 < argc)
+            statsInterval = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--temporal") == 0 && i + 1 < argc)
+            temporalFraction = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--resolution-target") == 0 && i + 1 < argc)
+            resolutionTarget = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--accumulate") == 0 && i + 1 < argc)
+            accumulationSamples = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--volume") == 0 && i + 1 < argc)
+            volumeResolution = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--bricks") == 0 && i + 1 < argc)
+            brickResolution = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--clipmap") == 0 && i + 1 < argc)
+            clipmapSize = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--symmetric") == 0)
+            symmetric = true;
+    }
+
+    CameraScript script;
+    if (benchmarkPath) {
+        std::string error;
+        if (!script.load(benchmarkPath, error)) {
+            std::cout << "ERROR::BENCHMARK::INVALID_SCRIPT: " << benchmarkPath << ": " << error << std::endl;
+            return -1;
+        }
+    }
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
@@ -42,7 +115,15 @@ int main() {
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Fractal", NULL, NULL);
+    int windowWidth = SCR_WIDTH;
+    int windowHeight = SCR_HEIGHT;
+    if (benchmarkPath) {
+        windowWidth = script.Width;
+        windowHeight = script.Height;
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    }
+
+    GLFWwindow* window = glfwCreateWindow(windowWidth, windowHeight, "Fractal", NULL, NULL);
     if (window == NULL) {
         std::cout << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -50,38 +131,50 @@ int main() {
     }
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
-    glfwSetCursorPosCallback(window, mouseCallback);
-    glfwSetScrollCallback(window, scrollCallback);
+    glfwSetWindowRefreshCallback(window, refreshCallback);
 
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (!benchmarkPath) {
+        glfwSetCursorPosCallback(window, mouseCallback);
+        glfwSetScrollCallback(window, scrollCallback);
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    }
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
 
-    Shader shader(SHADER_PATH "vertex.glsl", SHADER_PATH "fragment.glsl");
-
-    float quadVertices[] = {
-        -1.0f,  1.0f,  0.0f, 1.0f,
-        -1.0f, -1.0f,  0.0f, 0.0f,
-         1.0f, -1.0f,  1.0f, 0.0f,
-
-        -1.0f,  1.0f,  0.0f, 1.0f,
-         1.0f, -1.0f,  1.0f, 0.0f,
-         1.0f,  1.0f,  1.0f, 1.0f
-    };
+    auto renderer = std::make_unique<ShaderRenderer>(SHADER_PATH "vertex.glsl", SHADER_PATH "fragment.glsl", true);
+    renderer->TemporalFraction = temporalFraction;
+
+    // Baked on the first run with these settings, mapped from the cache after.
+    // It covers the starting iteration count and below.
+    if (volumeResolution >= 2) {
+        DistanceVolume volume;
+        ThreadPool bakePool;
+        if (volume.load(DistanceVolume::defaultDirectory(), volumeResolution, maxIterations, bakePool, symmetric))
+            renderer->setDistanceVolume(volume);
+    } else if (brickResolution >= BrickMap::BRICK_SIZE) {
+        BrickMap bricks;
+        ThreadPool bakePool;
+        if (bricks.load(DistanceVolume::defaultDirectory(), brickResolution / BrickMap::BRICK_SIZE,
+                        maxIterations, bakePool, symmetric))
+            renderer->setBrickMap(bricks);
+    } else if (clipmapSize >= 2) {
+        clipmap = std::make_unique<DistanceClipmap>(clipmapSize);
+        clipmapPool = std::make_unique<ThreadPool>();
+    }
 
-    unsigned int quadVAO, quadVBO;
-    glGenVertexArrays(1, &quadVAO);
-    glGenBuffers(1, &quadVBO);
-    glBindVertexArray(quadVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    if (benchmarkPath) {
+        FrameStatsRecorder stats(0.0);
+        int result = runBenchmark(window, *renderer, script, stats);
+        stats.stop();
+        if (statsPath)
+            stats.dump(statsPath);
+        renderer.reset();
+        glfwTerminate();
+        return result;
+    }
 
     std::cout << "Controls:" << std::endl;
     std::cout << "WASD - Move horizontally" << std::endl;
@@ -93,53 +186,292 @@ int main() {
     std::cout << "ESC - Exit" << std::endl;
     std::cout << "\nStarting iterations: " << maxIterations << std::endl;
 
+    auto gpuTimer = std::make_unique<GpuTimer>();
+    int fractalStage = gpuTimer->addStage("fractal");
+
+    // Terminal output happens on the recorder's thread, off the render path.
+    FrameStatsRecorder stats(statsInterval);
+    long long frameNumber = 0;
+
+    // Saving a file in shaders/ rebuilds the programs without a restart.
+    ShaderWatcher shaderWatcher(SHADER_PATH);
+
+    // The fractal is drawn at a fraction of the window size chosen to hold the
+    // GPU time near the target, then stretched to the window. GPU results
+    // arrive a few frames late, so the scale each frame used is remembered.
+    ResolutionController resolution;
+    resolution.TargetMs = resolutionTarget;
+    auto scaledTarget = std::make_unique<RenderTarget>();
+    float frameScales[8] = {};
+
+    // While nothing moves, the animation clock stops so the view stays the
+    // same: each frame then adds an anti-aliasing sample, and once those are
+    // done nothing is drawn until there is input.
+    renderer->AccumulationSamples = accumulationSamples;
+    float animationTime = 0.0f;
+    ViewParams lastView;
+    bool hasLastView = false;
+    float lastRenderScale = 1.0f;
+
     while (!glfwWindowShouldClose(window)) {
-        float currentFrame = static_cast<float>(glfwGetTime());
+        if (glfwGetWindowAttrib(window, GLFW_ICONIFIED)) {
+            glfwWaitEventsTimeout(IDLE_WAIT);
+            lastFrame = static_cast<float>(glfwGetTime());
+            continue;
+        }
+
+        double frameStart = glfwGetTime();
+        float currentFrame = static_cast<float>(frameStart);
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
-        std::cout << "\rFPS: " << static_cast<int>(1.0f / deltaTime)
-          << " | Zoom Level: 2^" << cameraExponent
-          << " | Max Iterations: " << maxIterations
-          << " | Speed: " << camera.MovementSpeed
-          << std::flush;
-
         processInput(window);
 
+        if (shaderWatcher.poll()) {
+            std::cout << "\nReloading shaders..." << std::endl;
+            renderer->reload();
+        }
+
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+
+        // time only moves the light and autoRotate, so it advances with the
+        // camera rather than making every frame different.
+        ViewParams still = currentView(width, height, animationTime);
+        bool idle = !autoRotate && hasLastView && ShaderRenderer::sameImage(still, lastView);
+        if (!idle)
+            animationTime += deltaTime;
+        lastView = currentView(width, height, animationTime);
+        hasLastView = true;
+
+        bool dirty = !idle || redrawRequested || lastRenderScale < 1.0f ||
+                     !renderer->ready() || renderer->reloadPending() ||
+                     renderer->accumulatedSamples() < accumulationSamples;
+        redrawRequested = false;
+        if (!dirty) {
+            glfwWaitEventsTimeout(IDLE_WAIT);
+            lastFrame = static_cast<float>(glfwGetTime());
+            continue;
+        }
+
+        // CPU is the time spent issuing the frame, GPU the time the GPU spent
+        // executing it; frame time alone cannot tell which one (or vsync) is the limit.
+        FrameSample sample;
+        sample.frame = frameNumber++;
+        if (gpuTimer->beginFrame()) {
+            sample.gpuFrame = gpuTimer->resultFrame();
+            sample.gpuMs = gpuTimer->frameMs();
+            float measuredScale = frameScales[sample.gpuFrame % 8];
+            if (resolutionTarget > 0.0 && measuredScale > 0.0f)
+                resolution.update(gpuTimer->stageMs(fractalStage), measuredScale);
+        }
+
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        shader.use();
+        // Still frames are accumulated at full size; their cost says nothing
+        // about the cost of a moving frame, so the controller skips them.
+        float renderScale = resolutionTarget > 0.0 && !idle ? resolution.scale() : 1.0f;
+        int renderWidth = std::max(1, static_cast<int>(std::lround(width * renderScale)));
+        int renderHeight = std::max(1, static_cast<int>(std::lround(height * renderScale)));
+        bool scaled = renderScale < 1.0f && scaledTarget->resize(renderWidth, renderHeight, GL_RGBA8);
+        if (!scaled) {
+            renderScale = 1.0f;
+            renderWidth = width;
+            renderHeight = height;
+        }
+        frameScales[sample.frame % 8] = idle ? 0.0f : renderScale;
+        lastRenderScale = renderScale;
+
+        ViewParams view = currentView(renderWidth, renderHeight, animationTime);
+        updateClipmap(*renderer, view);
+        if (scaled)
+            scaledTarget->bind();
+        gpuTimer->beginStage(fractalStage);
+        renderer->draw(view);
+        gpuTimer->endStage(fractalStage);
+        if (scaled) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, scaledTarget->FBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, width, height,
+                              GL_COLOR_BUFFER_BIT, GL_LINEAR);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, width, height);
+        }
+
+        gpuTimer->endFrame();
+        double submitted = glfwGetTime();
 
-        float scale = std::pow(2.0f, static_cast<float>(cameraExponent));
-        glm::vec3 worldPos = cameraMantissa * scale;
+        glfwSwapBuffers(window);
+        double swapped = glfwGetTime();
+        if (glfwGetWindowAttrib(window, GLFW_FOCUSED))
+            glfwPollEvents();
+        else
+            glfwWaitEventsTimeout(std::max(0.0, UNFOCUSED_FRAME - (swapped - frameStart)));
+
+        sample.cpuMs = (submitted - frameStart) * 1000.0;
+        sample.swapMs = (swapped - submitted) * 1000.0;
+        sample.frameMs = (glfwGetTime() - frameStart) * 1000.0;
+        sample.mantissa = cameraMantissa;
+        sample.exponent = cameraExponent;
+        sample.maxIterations = view.fractal.maxIterations;
+        sample.time = view.fractal.time;
+        sample.speed = camera.MovementSpeed;
+        sample.renderScale = renderScale;
+        stats.record(sample);
+    }
 
-        shader.setVec3("camPos", worldPos);
-        shader.setVec3("camFront", camera.Front);
-        shader.setVec3("camRight", camera.Right);
-        shader.setVec3("camUp", camera.Up);
-        shader.setFloat("fov", glm::radians(camera.Fov));
-        shader.setFloat("time", currentFrame);
-        shader.setFloat("scale", scale); 
+    stats.stop();
+    if (statsPath)
+        stats.dump(statsPath);
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
-        shader.setVec3("resolution", glm::vec3(width, height, 0.0f));
+    scaledTarget.reset();
+    gpuTimer.reset();
+    renderer.reset();
+    clipmap.reset();
+    clipmapPool.reset();
+    glfwTerminate();
+    return 0;
+}
+
+ViewParams currentView(int width, int height, float time) {
+    ViewParams view;
+    view.fractal.scale = std::pow(2.0f, static_cast<float>(cameraExponent));
+    view.fractal.time = time;
+    view.fractal.maxIterations = maxIterations;
+    view.fractal.autoRotate = autoRotate;
+    view.camPos = cameraMantissa * view.fractal.scale;
+    view.camFront = camera.Front;
+    view.camRight = camera.Right;
+    view.camUp = camera.Up;
+    view.fov = glm::radians(camera.Fov);
+    view.width = width;
+    view.height = height;
+    return view;
+}
+
+void updateClipmap(ShaderRenderer& renderer, const ViewParams& view) {
+    if (!clipmap)
+        return;
+    clipmap->update(toObjectSpace(view.camPos, view.fractal), std::max(1, view.fractal.maxIterations),
+                    CLIPMAP_BUDGET, *clipmapPool);
+    renderer.setClipmap(*clipmap);
+}
 
-        shader.setInt("maxIterations", maxIterations);
+// Replaces processInput with the scripted flight and renders every frame at
+// the script's resolution into an offscreen target, so timings do not depend
+// on window size, DPI scaling or vsync.
+int runBenchmark(GLFWwindow* window, ShaderRenderer& renderer, const CameraScript& script,
+                 FrameStatsRecorder& stats) {
+    glfwSwapInterval(0);
 
-        glBindVertexArray(quadVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+    RenderTarget target;
+    if (!target.resize(script.Width, script.Height, GL_RGBA8))
+        return -1;
+
+    std::cout << "Benchmark: " << script.FrameCount << " frames at " << script.Width << "x" << script.Height
+              << " (" << script.WarmupFrames << " warm-up)" << std::endl;
+
+    GpuTimer gpuTimer;
+    int fractalStage = gpuTimer.addStage("fractal");
+
+    std::vector<double> frameMs;
+    std::vector<double> gpuMs;
+    frameMs.reserve(script.FrameCount);
+    gpuMs.reserve(script.FrameCount);
+
+    int totalFrames = script.WarmupFrames + script.FrameCount;
+    for (int frame = 0; frame < totalFrames && !glfwWindowShouldClose(window); frame++) {
+        CameraKey key = script.sample(std::max(0, frame - script.WarmupFrames));
+        cameraMantissa = key.mantissa;
+        cameraExponent = key.exponent;
+        maxIterations = key.maxIterations;
+        camera = Camera(camera.Position, camera.WorldUp, key.yaw, key.pitch);
+
+        // Compiles stay out of the measured frame.
+        ViewParams view = currentView(script.Width, script.Height, key.time);
+        renderer.waitUntilReady(view);
+
+        double start = glfwGetTime();
+
+        FrameSample sample;
+        sample.frame = frame;
+        if (gpuTimer.beginFrame()) {
+            sample.gpuFrame = gpuTimer.resultFrame();
+            sample.gpuMs = gpuTimer.frameMs();
+            if (sample.gpuFrame >= script.WarmupFrames)
+                gpuMs.push_back(sample.gpuMs);
+        }
+
+        updateClipmap(renderer, view);
+        target.bind();
+        gpuTimer.beginStage(fractalStage);
+        renderer.draw(view);
+        gpuTimer.endStage(fractalStage);
+
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, target.FBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, script.Width, script.Height, 0, 0, width, height,
+                          GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        gpuTimer.endFrame();
+        double submitted = glfwGetTime();
 
         glfwSwapBuffers(window);
+        glFinish();
+
+        double end = glfwGetTime();
+        double ms = (end - start) * 1000.0;
+        if (frame >= script.WarmupFrames)
+            frameMs.push_back(ms);
+
+        sample.cpuMs = (submitted - start) * 1000.0;
+        sample.swapMs = (end - submitted) * 1000.0;
+        sample.frameMs = ms;
+        sample.mantissa = key.mantissa;
+        sample.exponent = key.exponent;
+        sample.maxIterations = key.maxIterations;
+        sample.time = key.time;
+        stats.record(sample);
+
         glfwPollEvents();
     }
 
-    glDeleteVertexArrays(1, &quadVAO);
-    glDeleteBuffers(1, &quadVBO);
+    // Collect the frames still in flight in the timer ring.
+    for (int i = 0; i < 8; i++) {
+        if (gpuTimer.beginFrame()) {
+            FrameSample late;
+            late.frame = -1;
+            late.gpuFrame = gpuTimer.resultFrame();
+            late.gpuMs = gpuTimer.frameMs();
+            if (late.gpuFrame >= script.WarmupFrames)
+                gpuMs.push_back(late.gpuMs);
+            stats.record(late);
+        }
+        gpuTimer.endFrame();
+        glFinish();
+    }
 
-    glfwTerminate();
-    return 0;
+    FrameTimeSummary summary = summarizeFrameTimes(frameMs);
+    FrameTimeSummary gpuSummary = summarizeFrameTimes(gpuMs);
+    std::cout << "Frames: " << summary.count << "\n"
+              << "Frame time (ms): min " << summary.minMs
+              << " | mean " << summary.meanMs
+              << " | p50 " << summary.p50Ms
+              << " | p95 " << summary.p95Ms
+              << " | p99 " << summary.p99Ms
+              << " | max " << summary.maxMs << "\n"
+              << "GPU time (ms):   min " << gpuSummary.minMs
+              << " | mean " << gpuSummary.meanMs
+              << " | p50 " << gpuSummary.p50Ms
+              << " | p95 " << gpuSummary.p95Ms
+              << " | p99 " << gpuSummary.p99Ms
+              << " | max " << gpuSummary.maxMs << "\n"
+              << "FPS: " << summary.fps << std::endl;
+
+    return summary.count == static_cast<size_t>(script.FrameCount) ? 0 : -1;
 }
 
 void processInput(GLFWwindow* window) {
@@ -240,4 +572,9 @@ void mouseCallback(GLFWwindow* window, double xposIn, double yposIn) {
 
 void scrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.processMouseScroll(static_cast<float>(yoffset));
+}
+
+// The window system lost the contents, e.g. after being uncovered.
+void refreshCallback(GLFWwindow* window) {
+    redrawRequested = true;
 }
\ No newline at end of file
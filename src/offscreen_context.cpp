@@ -0,0 +1,124 @@
+#include "offscreen_context.h"
+#include <glad/glad.h>
+
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+#include <iostream>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static bool hasExtension(const char* list, const char* name) {
+    if (!list)
+        return false;
+
+    size_t len = std::strlen(name);
+    for (const char* p = std::strstr(list, name); p; p = std::strstr(p + len, name)) {
+        bool startOk = p == list || p[-1] == ' ';
+        bool endOk = p[len] == ' ' || p[len] == '\0';
+        if (startOk && endOk)
+            return true;
+    }
+    return false;
+}
+
+static EGLDisplay openDisplay() {
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+    if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay) {
+            EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY)
+                return display;
+        }
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+OffscreenContext::~OffscreenContext() {
+    if (!display)
+        return;
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context)
+        eglDestroyContext(display, context);
+    eglTerminate(display);
+}
+
+bool OffscreenContext::create(int major, int minor) {
+    EGLDisplay eglDisplay = openDisplay();
+    EGLint eglMajor, eglMinor;
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &eglMajor, &eglMinor)) {
+        std::cerr << "ERROR::EGL::NO_DISPLAY: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        return false;
+    }
+    display = eglDisplay;
+
+    const char* extensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+    if (!hasExtension(extensions, "EGL_KHR_surfaceless_context")) {
+        std::cerr << "ERROR::EGL::SURFACELESS_CONTEXT_NOT_SUPPORTED" << std::endl;
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "ERROR::EGL::OPENGL_API_NOT_SUPPORTED" << std::endl;
+        return false;
+    }
+
+    EGLConfig config = nullptr;
+    if (!hasExtension(extensions, "EGL_KHR_no_config_context")) {
+        const EGLint configAttribs[] = {
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        EGLint count = 0;
+        if (!eglChooseConfig(eglDisplay, configAttribs, &config, 1, &count) || count == 0) {
+            std::cerr << "ERROR::EGL::NO_CONFIG" << std::endl;
+            return false;
+        }
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, major,
+        EGL_CONTEXT_MINOR_VERSION, minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        context = nullptr;
+        std::cerr << "ERROR::EGL::CONTEXT_CREATION_FAILED: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        return false;
+    }
+
+    if (!makeCurrent())
+        return false;
+
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(&OffscreenContext::getProcAddress))) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool OffscreenContext::makeCurrent() {
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::cerr << "ERROR::EGL::MAKE_CURRENT_FAILED: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const char* OffscreenContext::renderer() const {
+    return reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+}
+
+void* OffscreenContext::getProcAddress(const char* name) {
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
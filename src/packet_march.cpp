@@ -0,0 +1,153 @@
+#include "packet_march.h"
+#include <atomic>
+
+#if defined(FRACTAL_X86_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifdef FRACTAL_X86_SIMD
+size_t marchRaysSSE42(const RayBatch& rays, const FractalParams& params, MarchBatch& out,
+                      const MarchSettings& settings, const float* starts, const float* limits);
+size_t marchRaysAVX2(const RayBatch& rays, const FractalParams& params, MarchBatch& out,
+                     const MarchSettings& settings, const float* starts, const float* limits);
+size_t marchRaysAVX512(const RayBatch& rays, const FractalParams& params, MarchBatch& out,
+                       const MarchSettings& settings, const float* starts, const float* limits);
+#endif
+
+void RayBatch::resize(size_t count) {
+    ox.resize(count);
+    oy.resize(count);
+    oz.resize(count);
+    dx.resize(count);
+    dy.resize(count);
+    dz.resize(count);
+    startDepth.resize(count);
+    startTrap.resize(count);
+}
+
+void RayBatch::set(size_t i, const glm::vec3& origin, const glm::vec3& dir, float start, float trap) {
+    ox[i] = origin.x;
+    oy[i] = origin.y;
+    oz[i] = origin.z;
+    dx[i] = dir.x;
+    dy[i] = dir.y;
+    dz[i] = dir.z;
+    startDepth[i] = start;
+    startTrap[i] = trap;
+}
+
+void MarchBatch::resize(size_t count) {
+    depth.resize(count);
+    steps.resize(count);
+    evaluations.resize(count);
+    hit.resize(count);
+    orbitTrap.resize(count);
+}
+
+#if defined(FRACTAL_X86_SIMD) && defined(_MSC_VER)
+static bool cpuHas(int leaf, int reg, int bit) {
+    int info[4];
+    __cpuidex(info, leaf, 0);
+    return (info[reg] >> bit) & 1;
+}
+
+static bool osSavesYmm() {
+    return cpuHas(1, 2, 27) && (_xgetbv(0) & 0x6) == 0x6;
+}
+
+static bool osSavesZmm() {
+    return cpuHas(1, 2, 27) && (_xgetbv(0) & 0xE6) == 0xE6;
+}
+#endif
+
+SimdLevel detectSimdLevel() {
+#if defined(FRACTAL_X86_SIMD) && defined(_MSC_VER)
+    if (cpuHas(7, 1, 16) && osSavesZmm())
+        return SimdLevel::AVX512;
+    if (cpuHas(7, 1, 5) && osSavesYmm())
+        return SimdLevel::AVX2;
+    if (cpuHas(1, 2, 20))
+        return SimdLevel::SSE42;
+#elif defined(FRACTAL_X86_SIMD)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return SimdLevel::SSE42;
+#endif
+    return SimdLevel::Scalar;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SSE42: return "SSE4.2";
+    case SimdLevel::AVX2: return "AVX2";
+    case SimdLevel::AVX512: return "AVX-512";
+    default: return "scalar";
+    }
+}
+
+static std::atomic<int> selectedLevel(-1);
+
+SimdLevel activeSimdLevel() {
+    int level = selectedLevel.load(std::memory_order_relaxed);
+    if (level < 0) {
+        level = static_cast<int>(detectSimdLevel());
+        selectedLevel.store(level, std::memory_order_relaxed);
+    }
+    return static_cast<SimdLevel>(level);
+}
+
+void setSimdLevel(SimdLevel level) {
+    SimdLevel best = detectSimdLevel();
+    if (static_cast<int>(level) > static_cast<int>(best))
+        level = best;
+    selectedLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void marchRays(const RayBatch& rays, const FractalParams& params, MarchBatch& out,
+               const MarchSettings& settings) {
+    out.resize(rays.size());
+
+    size_t done = 0;
+#ifdef FRACTAL_X86_SIMD
+    SimdLevel level = activeSimdLevel();
+    if (level != SimdLevel::Scalar) {
+        // Once per ray, so the scalar interval is cheap enough here, outside
+        // the ISA kernels.
+        thread_local std::vector<float> starts, limits;
+        starts.resize(rays.size());
+        limits.resize(rays.size());
+        for (size_t i = 0; i < rays.size(); i++) {
+            if (!marchInterval(glm::vec3(rays.ox[i], rays.oy[i], rays.oz[i]),
+                               glm::vec3(rays.dx[i], rays.dy[i], rays.dz[i]), params, settings,
+                               rays.startDepth[i], starts[i], limits[i])) {
+                starts[i] = farLimit(params);
+                limits[i] = farLimit(params);
+            }
+        }
+
+        const float* s = starts.data();
+        const float* l = limits.data();
+        switch (level) {
+        case SimdLevel::AVX512: done = marchRaysAVX512(rays, params, out, settings, s, l); break;
+        case SimdLevel::AVX2: done = marchRaysAVX2(rays, params, out, settings, s, l); break;
+        case SimdLevel::SSE42: done = marchRaysSSE42(rays, params, out, settings, s, l); break;
+        default: break;
+        }
+    }
+#endif
+
+    for (size_t i = done; i < rays.size(); i++) {
+        MarchResult r = rayMarch(glm::vec3(rays.ox[i], rays.oy[i], rays.oz[i]),
+                                 glm::vec3(rays.dx[i], rays.dy[i], rays.dz[i]), params, settings,
+                                 rays.startDepth[i], rays.startTrap[i]);
+        out.depth[i] = r.depth;
+        out.steps[i] = r.steps;
+        out.evaluations[i] = r.evaluations;
+        out.hit[i] = r.hit ? 1 : 0;
+        out.orbitTrap[i] = r.orbitTrap;
+    }
+}
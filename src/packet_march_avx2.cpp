@@ -0,0 +1,46 @@
+#define FRACTAL_PACKET_TARGET FRACTAL_TARGET("avx2")
+#include "packet_march_kernel.h"
+#include <immintrin.h>
+
+namespace {
+
+struct LanesAVX2 {
+    static const int Width = 8;
+    typedef __m256 F;
+    typedef __m256 M;
+
+    FRACTAL_PACKET_TARGET static F load(const float* p) { return _mm256_loadu_ps(p); }
+    FRACTAL_PACKET_TARGET static void store(float* p, F a) { _mm256_storeu_ps(p, a); }
+    FRACTAL_PACKET_TARGET static F set1(float a) { return _mm256_set1_ps(a); }
+    FRACTAL_PACKET_TARGET static F add(F a, F b) { return _mm256_add_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F div(F a, F b) { return _mm256_div_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F min(F a, F b) { return _mm256_min_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F max(F a, F b) { return _mm256_max_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F abs(F a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    FRACTAL_PACKET_TARGET static F sqrt(F a) { return _mm256_sqrt_ps(a); }
+    FRACTAL_PACKET_TARGET static M lt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    FRACTAL_PACKET_TARGET static M ge(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    FRACTAL_PACKET_TARGET static M andMask(M a, M b) { return _mm256_and_ps(a, b); }
+    FRACTAL_PACKET_TARGET static M orMask(M a, M b) { return _mm256_or_ps(a, b); }
+    FRACTAL_PACKET_TARGET static M andNot(M a, M b) { return _mm256_andnot_ps(b, a); }
+    FRACTAL_PACKET_TARGET static F select(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+    FRACTAL_PACKET_TARGET static bool any(M m) { return _mm256_movemask_ps(m) != 0; }
+
+    FRACTAL_PACKET_TARGET static void storeSteps(int* p, F a) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm256_cvttps_epi32(a));
+    }
+    FRACTAL_PACKET_TARGET static void storeHit(uint8_t* p, M m) {
+        int bits = _mm256_movemask_ps(m);
+        for (int i = 0; i < Width; i++)
+            p[i] = static_cast<uint8_t>((bits >> i) & 1);
+    }
+};
+
+}
+
+FRACTAL_PACKET_TARGET size_t marchRaysAVX2(const RayBatch& rays, const FractalParams& params, MarchBatch& out,
+                                           const MarchSettings& settings, const float* starts, const float* limits) {
+    return marchPackets<LanesAVX2>(rays, params, out, settings, starts, limits);
+}
@@ -0,0 +1,45 @@
+#define FRACTAL_PACKET_TARGET FRACTAL_TARGET("avx512f")
+#include "packet_march_kernel.h"
+#include <immintrin.h>
+
+namespace {
+
+struct LanesAVX512 {
+    static const int Width = 16;
+    typedef __m512 F;
+    typedef __mmask16 M;
+
+    FRACTAL_PACKET_TARGET static F load(const float* p) { return _mm512_loadu_ps(p); }
+    FRACTAL_PACKET_TARGET static void store(float* p, F a) { _mm512_storeu_ps(p, a); }
+    FRACTAL_PACKET_TARGET static F set1(float a) { return _mm512_set1_ps(a); }
+    FRACTAL_PACKET_TARGET static F add(F a, F b) { return _mm512_add_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F sub(F a, F b) { return _mm512_sub_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F mul(F a, F b) { return _mm512_mul_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F div(F a, F b) { return _mm512_div_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F min(F a, F b) { return _mm512_min_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F max(F a, F b) { return _mm512_max_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F abs(F a) { return _mm512_abs_ps(a); }
+    FRACTAL_PACKET_TARGET static F sqrt(F a) { return _mm512_sqrt_ps(a); }
+    FRACTAL_PACKET_TARGET static M lt(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    FRACTAL_PACKET_TARGET static M ge(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+    FRACTAL_PACKET_TARGET static M andMask(M a, M b) { return static_cast<M>(a & b); }
+    FRACTAL_PACKET_TARGET static M orMask(M a, M b) { return static_cast<M>(a | b); }
+    FRACTAL_PACKET_TARGET static M andNot(M a, M b) { return static_cast<M>(a & ~b); }
+    FRACTAL_PACKET_TARGET static F select(M m, F a, F b) { return _mm512_mask_blend_ps(m, b, a); }
+    FRACTAL_PACKET_TARGET static bool any(M m) { return m != 0; }
+
+    FRACTAL_PACKET_TARGET static void storeSteps(int* p, F a) {
+        _mm512_storeu_si512(p, _mm512_cvttps_epi32(a));
+    }
+    FRACTAL_PACKET_TARGET static void storeHit(uint8_t* p, M m) {
+        for (int i = 0; i < Width; i++)
+            p[i] = static_cast<uint8_t>((m >> i) & 1);
+    }
+};
+
+}
+
+FRACTAL_PACKET_TARGET size_t marchRaysAVX512(const RayBatch& rays, const FractalParams& params, MarchBatch& out,
+                                             const MarchSettings& settings, const float* starts, const float* limits) {
+    return marchPackets<LanesAVX512>(rays, params, out, settings, starts, limits);
+}
@@ -0,0 +1,260 @@
+#ifndef PACKET_MARCH_KERNEL_H
+#define PACKET_MARCH_KERNEL_H
+
+// ISA-independent body of the packet ray marcher. Each packet_march_<isa>.cpp
+// defines FRACTAL_PACKET_TARGET as FRACTAL_TARGET("<isa>"), includes this and
+// instantiates marchPackets<> with a lane type V providing:
+//   V::Width, V::F (float lanes), V::M (lane mask)
+//   load, store, set1, add, sub, mul, div, min, max, abs, sqrt
+//   lt, ge, andMask, orMask, andNot (a & ~b), select(m, a, b), any
+//   storeSteps, storeHit
+// Lane results are bit-identical to the scalar rayMarch() in fractal.cpp.
+//
+// The files are compiled for the baseline ISA; only the functions marked
+// FRACTAL_PACKET_TARGET, all with internal linkage but the entry point, use
+// the wider one. Inline glm and std code the files emit therefore matches
+// every other copy of it, so the linker may keep any of them, and none runs
+// before the dispatch has checked the CPU.
+
+#include "packet_march.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef FRACTAL_PACKET_TARGET
+#error "define FRACTAL_PACKET_TARGET before including packet_march_kernel.h"
+#endif
+
+// MSVC has no per-function target; its intrinsics need none.
+#ifdef _MSC_VER
+#define FRACTAL_TARGET(isa)
+#else
+#define FRACTAL_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace {
+
+template <typename V>
+struct PacketVec3 {
+    typename V::F x, y, z;
+};
+
+// Lanes stop at their own iteration count or on escape; the loop ends when
+// every lane has.
+template <typename V>
+FRACTAL_PACKET_TARGET inline typename V::F packetMandelboxDE(const PacketVec3<V>& pos, typename V::F iterations,
+                                       int maxIterations, typename V::F& orbitTrap) {
+    using F = typename V::F;
+    using M = typename V::M;
+
+    const float minR2 = MANDELBOX_MIN_RADIUS * MANDELBOX_MIN_RADIUS;
+    const float fixedR2 = MANDELBOX_FIXED_RADIUS * MANDELBOX_FIXED_RADIUS;
+
+    const F one = V::set1(1.0f);
+    const F negOne = V::set1(-1.0f);
+    const F two = V::set1(2.0f);
+    const F scale = V::set1(MANDELBOX_SCALE);
+    const F absScale = V::set1(std::abs(MANDELBOX_SCALE));
+    const F minR2v = V::set1(minR2);
+    const F fixedR2v = V::set1(fixedR2);
+    const F innerT = V::set1(fixedR2 / minR2);
+    const F escapeR2 = V::set1(ESCAPE_RADIUS2);
+
+    F zx = pos.x, zy = pos.y, zz = pos.z;
+    F dr = one;
+    orbitTrap = V::set1(1000.0f);
+
+    // State after the last whole iteration of a fractional count.
+    F lowerX = pos.x, lowerY = pos.y, lowerZ = pos.z;
+    F lowerDr = one;
+    F lowerTrap = orbitTrap;
+    F blend = V::set1(0.0f);
+    M running = V::lt(V::set1(0.0f), iterations);
+    M blended = V::andNot(running, running);
+
+    for (int i = 0; i < maxIterations && V::any(running); i++) {
+        M last = V::andMask(running, V::lt(iterations, V::set1(static_cast<float>(i + 1))));
+        if (V::any(last)) {
+            lowerX = V::select(last, zx, lowerX);
+            lowerY = V::select(last, zy, lowerY);
+            lowerZ = V::select(last, zz, lowerZ);
+            lowerDr = V::select(last, dr, lowerDr);
+            lowerTrap = V::select(last, orbitTrap, lowerTrap);
+            blend = V::select(last, V::sub(iterations, V::set1(static_cast<float>(i))), blend);
+            blended = V::orMask(blended, last);
+        }
+
+        F fx = V::sub(V::mul(V::min(V::max(zx, negOne), one), two), zx);
+        F fy = V::sub(V::mul(V::min(V::max(zy, negOne), one), two), zy);
+        F fz = V::sub(V::mul(V::min(V::max(zz, negOne), one), two), zz);
+
+        F r2 = V::add(V::add(V::mul(fx, fx), V::mul(fy, fy)), V::mul(fz, fz));
+
+        M inner = V::lt(r2, minR2v);
+        M outer = V::andNot(V::lt(r2, fixedR2v), inner);
+        F t = V::select(inner, innerT, V::select(outer, V::div(fixedR2v, r2), one));
+
+        zx = V::select(running, V::add(V::mul(V::mul(fx, t), scale), pos.x), zx);
+        zy = V::select(running, V::add(V::mul(V::mul(fy, t), scale), pos.y), zy);
+        zz = V::select(running, V::add(V::mul(V::mul(fz, t), scale), pos.z), zz);
+        dr = V::select(running, V::add(V::mul(V::mul(dr, t), absScale), one), dr);
+
+        orbitTrap = V::select(running, V::min(orbitTrap,
+                              V::add(V::add(V::abs(zx), V::abs(zy)), V::abs(zz))), orbitTrap);
+
+        F zr2 = V::add(V::add(V::mul(zx, zx), V::mul(zy, zy)), V::mul(zz, zz));
+        running = V::andNot(running, V::lt(escapeR2, zr2));
+        running = V::andNot(running, V::ge(V::set1(static_cast<float>(i + 1)), iterations));
+    }
+
+    F len = V::sqrt(V::add(V::add(V::mul(zx, zx), V::mul(zy, zy)), V::mul(zz, zz)));
+    F de = V::div(len, V::abs(dr));
+    if (!V::any(blended))
+        return de;
+
+    F lowerLen = V::sqrt(V::add(V::add(V::mul(lowerX, lowerX), V::mul(lowerY, lowerY)), V::mul(lowerZ, lowerZ)));
+    F lower = V::div(lowerLen, V::abs(lowerDr));
+    F blendedTrap = V::add(V::mul(lowerTrap, V::sub(one, blend)), V::mul(orbitTrap, blend));
+    orbitTrap = V::select(blended, blendedTrap, orbitTrap);
+    return V::select(blended, V::add(V::mul(lower, V::sub(one, blend)), V::mul(de, blend)), de);
+}
+
+// iterationLod() per lane; there is no lane-wise log2, so this goes through
+// the scalar function.
+template <typename V>
+FRACTAL_PACKET_TARGET inline typename V::F packetIterationLod(typename V::F epsilon, const FractalParams& params) {
+    float lanes[V::Width];
+    V::store(lanes, epsilon);
+    for (int l = 0; l < V::Width; l++)
+        lanes[l] = iterationLod(lanes[l], params);
+    return V::load(lanes);
+}
+
+template <typename V>
+FRACTAL_PACKET_TARGET inline typename V::F packetSceneSDF(const PacketVec3<V>& p, const FractalParams& params,
+                                    typename V::F iterations, typename V::F& orbitTrap) {
+    using F = typename V::F;
+
+    F scaleV = V::set1(params.scale);
+    PacketVec3<V> obj{ V::div(p.x, scaleV), V::div(p.y, scaleV), V::div(p.z, scaleV) };
+
+    if (params.autoRotate) {
+        float angle = params.time * 0.1f;
+        float s = std::sin(angle);
+        float c = std::cos(angle);
+        F vc = V::set1(c), vs = V::set1(s), vns = V::set1(-s);
+        F zero = V::set1(0.0f), vone = V::set1(1.0f);
+
+        // Same column-major product as glm::mat3 * vec3 in toObjectSpace().
+        PacketVec3<V> r;
+        r.x = V::add(V::add(V::mul(vc, obj.x), V::mul(zero, obj.y)), V::mul(vns, obj.z));
+        r.y = V::add(V::add(V::mul(zero, obj.x), V::mul(vone, obj.y)), V::mul(zero, obj.z));
+        r.z = V::add(V::add(V::mul(vs, obj.x), V::mul(zero, obj.y)), V::mul(vc, obj.z));
+        obj = r;
+    }
+
+    return V::mul(packetMandelboxDE<V>(obj, iterations, params.maxIterations, orbitTrap), scaleV);
+}
+
+// Marches rays [0, n) where n is the largest multiple of V::Width not above
+// rays.size(). Returns n; the caller finishes the remainder. starts and limits
+// hold marchInterval() per ray, with both at farLimit() where it ruled the
+// ray out, so those lanes start inactive. Lanes fall back from
+// over-relaxation independently.
+template <typename V>
+FRACTAL_PACKET_TARGET size_t marchPackets(const RayBatch& rays, const FractalParams& params, MarchBatch& out,
+                                          const MarchSettings& settings, const float* starts, const float* limits) {
+    using F = typename V::F;
+    using M = typename V::M;
+
+    const size_t count = rays.size() - rays.size() % V::Width;
+    const F minDist = V::set1(MIN_DIST * params.scale);
+    const F maxDist = V::set1(farLimit(params));
+    const F footprint = V::set1(settings.pixelCone * HIT_FOOTPRINT);
+    const F one = V::set1(1.0f);
+    const bool relaxed = settings.relaxation > 1.0f;
+    const float relaxation = relaxed ? settings.relaxation : 1.0f;
+
+    for (size_t base = 0; base < count; base += V::Width) {
+        PacketVec3<V> ro{ V::load(&rays.ox[base]), V::load(&rays.oy[base]), V::load(&rays.oz[base]) };
+        PacketVec3<V> rd{ V::load(&rays.dx[base]), V::load(&rays.dy[base]), V::load(&rays.dz[base]) };
+
+        const F marchLimit = V::load(&limits[base]);
+
+        F depth = V::load(&starts[base]);
+        F steps = V::set1(0.0f);
+        F evaluations = V::set1(0.0f);
+        F orbitTrap = V::load(&rays.startTrap[base]);
+        F previousDepth = depth;
+        F previousDist = V::set1(0.0f);
+        F omega = V::set1(relaxation);
+        M active = V::lt(depth, marchLimit);
+        M hit = V::andNot(active, active);
+
+        for (int i = 0; i < MAX_STEPS && V::any(active); i++) {
+            steps = V::select(active, V::set1(static_cast<float>(i)), steps);
+            evaluations = V::select(active, V::add(evaluations, one), evaluations);
+
+            PacketVec3<V> p{ V::add(ro.x, V::mul(rd.x, depth)),
+                             V::add(ro.y, V::mul(rd.y, depth)),
+                             V::add(ro.z, V::mul(rd.z, depth)) };
+            F epsilon = V::max(minDist, V::mul(depth, footprint));
+            F trap;
+            F dist = packetSceneSDF<V>(p, params, packetIterationLod<V>(epsilon, params), trap);
+
+            M accepted = active;
+            if (relaxed) {
+                M overlapFails = V::lt(V::add(dist, previousDist), V::sub(depth, previousDepth));
+                M rejected = V::andMask(V::andMask(active, V::lt(one, omega)), overlapFails);
+                depth = V::select(rejected, V::add(previousDepth, previousDist), depth);
+                omega = V::select(rejected, one, omega);
+                accepted = V::andNot(active, rejected);
+            }
+
+            orbitTrap = V::select(accepted, V::min(orbitTrap, trap), orbitTrap);
+
+            M hitNow = V::andMask(accepted, V::lt(dist, epsilon));
+            hit = V::orMask(hit, hitNow);
+            active = V::andNot(active, hitNow);
+
+            M advance = V::andNot(accepted, hitNow);
+            previousDepth = V::select(advance, depth, previousDepth);
+            previousDist = V::select(advance, dist, previousDist);
+            depth = V::select(advance, V::add(depth, V::mul(dist, omega)), depth);
+            active = V::andNot(active, V::ge(depth, marchLimit));
+        }
+
+        // Only hits reached by a relaxed step can lie past the surface.
+        M refine = V::andMask(hit, V::lt(one, omega));
+        if (relaxed && V::any(refine)) {
+            const F half = V::set1(0.5f);
+            F lo = previousDepth;
+            F hi = depth;
+            for (int b = 0; b < BISECTION_STEPS; b++) {
+                F mid = V::mul(V::add(lo, hi), half);
+                PacketVec3<V> p{ V::add(ro.x, V::mul(rd.x, mid)),
+                                 V::add(ro.y, V::mul(rd.y, mid)),
+                                 V::add(ro.z, V::mul(rd.z, mid)) };
+                F midEpsilon = V::max(minDist, V::mul(mid, footprint));
+                F trap;
+                M inside = V::lt(packetSceneSDF<V>(p, params, packetIterationLod<V>(midEpsilon, params), trap),
+                                 midEpsilon);
+                hi = V::select(V::andMask(refine, inside), mid, hi);
+                lo = V::select(V::andNot(refine, inside), mid, lo);
+            }
+            depth = V::select(refine, hi, depth);
+            evaluations = V::select(refine, V::add(evaluations, V::set1(static_cast<float>(BISECTION_STEPS))), evaluations);
+        }
+
+        V::store(&out.depth[base], V::select(hit, depth, maxDist));
+        V::store(&out.orbitTrap[base], orbitTrap);
+        V::storeSteps(&out.steps[base], steps);
+        V::storeSteps(&out.evaluations[base], evaluations);
+        V::storeHit(&out.hit[base], hit);
+    }
+
+    return count;
+}
+
+}
+
+#endif
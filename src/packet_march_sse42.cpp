@@ -0,0 +1,46 @@
+#define FRACTAL_PACKET_TARGET FRACTAL_TARGET("sse4.2")
+#include "packet_march_kernel.h"
+#include <nmmintrin.h>
+
+namespace {
+
+struct LanesSSE42 {
+    static const int Width = 4;
+    typedef __m128 F;
+    typedef __m128 M;
+
+    FRACTAL_PACKET_TARGET static F load(const float* p) { return _mm_loadu_ps(p); }
+    FRACTAL_PACKET_TARGET static void store(float* p, F a) { _mm_storeu_ps(p, a); }
+    FRACTAL_PACKET_TARGET static F set1(float a) { return _mm_set1_ps(a); }
+    FRACTAL_PACKET_TARGET static F add(F a, F b) { return _mm_add_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F div(F a, F b) { return _mm_div_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F min(F a, F b) { return _mm_min_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F max(F a, F b) { return _mm_max_ps(a, b); }
+    FRACTAL_PACKET_TARGET static F abs(F a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    FRACTAL_PACKET_TARGET static F sqrt(F a) { return _mm_sqrt_ps(a); }
+    FRACTAL_PACKET_TARGET static M lt(F a, F b) { return _mm_cmplt_ps(a, b); }
+    FRACTAL_PACKET_TARGET static M ge(F a, F b) { return _mm_cmpge_ps(a, b); }
+    FRACTAL_PACKET_TARGET static M andMask(M a, M b) { return _mm_and_ps(a, b); }
+    FRACTAL_PACKET_TARGET static M orMask(M a, M b) { return _mm_or_ps(a, b); }
+    FRACTAL_PACKET_TARGET static M andNot(M a, M b) { return _mm_andnot_ps(b, a); }
+    FRACTAL_PACKET_TARGET static F select(M m, F a, F b) { return _mm_blendv_ps(b, a, m); }
+    FRACTAL_PACKET_TARGET static bool any(M m) { return _mm_movemask_ps(m) != 0; }
+
+    FRACTAL_PACKET_TARGET static void storeSteps(int* p, F a) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_cvttps_epi32(a));
+    }
+    FRACTAL_PACKET_TARGET static void storeHit(uint8_t* p, M m) {
+        int bits = _mm_movemask_ps(m);
+        for (int i = 0; i < Width; i++)
+            p[i] = static_cast<uint8_t>((bits >> i) & 1);
+    }
+};
+
+}
+
+FRACTAL_PACKET_TARGET size_t marchRaysSSE42(const RayBatch& rays, const FractalParams& params, MarchBatch& out,
+                                            const MarchSettings& settings, const float* starts, const float* limits) {
+    return marchPackets<LanesSSE42>(rays, params, out, settings, starts, limits);
+}
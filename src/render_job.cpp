@@ -0,0 +1,149 @@
+#include "render_job.h"
+#include "camera.h"
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+ViewParams makeViewParams(const FrameJob& job) {
+    Camera camera(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f), job.yaw, job.pitch);
+
+    ViewParams view;
+    view.fractal.scale = std::pow(2.0f, static_cast<float>(job.exponent));
+    view.fractal.maxIterations = job.maxIterations;
+    view.fractal.time = job.time;
+    view.fractal.autoRotate = job.autoRotate;
+    view.camPos = job.mantissa * view.fractal.scale;
+    view.camFront = camera.Front;
+    view.camRight = camera.Right;
+    view.camUp = camera.Up;
+    view.fov = glm::radians(job.fov);
+    view.width = job.width;
+    view.height = job.height;
+    return view;
+}
+
+static bool readNumber(const JsonValue& object, const char* key, double& out, std::string& error) {
+    const JsonValue* value = object.find(key);
+    if (!value)
+        return true;
+    if (!value->isNumber()) {
+        error = std::string("'") + key + "' must be a number";
+        return false;
+    }
+    out = value->number;
+    return true;
+}
+
+template <typename T>
+static bool readField(const JsonValue& object, const char* key, T& field, std::string& error) {
+    double value = static_cast<double>(field);
+    if (!readNumber(object, key, value, error))
+        return false;
+    if constexpr (std::is_integral_v<T>) {
+        // Out-of-range conversions are undefined, and truncation would hide typos.
+        if (std::trunc(value) != value || value < static_cast<double>(std::numeric_limits<T>::lowest()) ||
+            value > static_cast<double>(std::numeric_limits<T>::max())) {
+            error = std::string("'") + key + "' must be an integer in range";
+            return false;
+        }
+    }
+    field = static_cast<T>(value);
+    return true;
+}
+
+bool applyJobJson(const JsonValue& object, FrameJob& job, std::string& error) {
+    if (!object.isObject()) {
+        error = "frame entry must be an object";
+        return false;
+    }
+
+    if (const JsonValue* mantissa = object.find("mantissa")) {
+        if (!mantissa->isArray() || mantissa->array.size() != 3 ||
+            !mantissa->array[0].isNumber() || !mantissa->array[1].isNumber() || !mantissa->array[2].isNumber()) {
+            error = "'mantissa' must be an array of three numbers";
+            return false;
+        }
+        job.mantissa = glm::vec3(mantissa->array[0].number, mantissa->array[1].number, mantissa->array[2].number);
+    }
+
+    if (!readField(object, "exponent", job.exponent, error) ||
+        !readField(object, "yaw", job.yaw, error) ||
+        !readField(object, "pitch", job.pitch, error) ||
+        !readField(object, "fov", job.fov, error) ||
+        !readField(object, "width", job.width, error) ||
+        !readField(object, "height", job.height, error) ||
+        !readField(object, "maxIterations", job.maxIterations, error) ||
+        !readField(object, "time", job.time, error))
+        return false;
+
+    if (const JsonValue* autoRotate = object.find("autoRotate")) {
+        if (autoRotate->type != JsonValue::Bool) {
+            error = "'autoRotate' must be true or false";
+            return false;
+        }
+        job.autoRotate = autoRotate->boolean;
+    }
+
+    if (const JsonValue* output = object.find("output")) {
+        if (!output->isString()) {
+            error = "'output' must be a string";
+            return false;
+        }
+        job.output = output->string;
+    }
+
+    if (job.width <= 0 || job.height <= 0) {
+        error = "resolution must be positive";
+        return false;
+    }
+    if (job.maxIterations < 0) {
+        error = "'maxIterations' must not be negative";
+        return false;
+    }
+    return true;
+}
+
+static std::string numberedPath(const std::string& path, size_t index) {
+    std::string suffix = std::to_string(index);
+    suffix = "_" + std::string(suffix.size() < 4 ? 4 - suffix.size() : 0, '0') + suffix;
+
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return path + suffix;
+    return path.substr(0, dot) + suffix + path.substr(dot);
+}
+
+bool loadJobFile(const char* filePath, const FrameJob& base,
+                 std::vector<FrameJob>& frames, std::string& error) {
+    JsonValue root;
+    if (!readJsonFile(filePath, root, error))
+        return false;
+
+    FrameJob defaults = base;
+    if (!applyJobJson(root, defaults, error))
+        return false;
+
+    const JsonValue* list = root.find("frames");
+    if (!list) {
+        frames.push_back(defaults);
+        return true;
+    }
+    if (!list->isArray()) {
+        error = "'frames' must be an array";
+        return false;
+    }
+
+    for (size_t i = 0; i < list->array.size(); i++) {
+        FrameJob frame = defaults;
+        frame.output.clear();
+        if (!applyJobJson(list->array[i], frame, error)) {
+            error = "frame " + std::to_string(i) + ": " + error;
+            return false;
+        }
+        if (frame.output.empty())
+            frame.output = numberedPath(defaults.output, i);
+        frames.push_back(frame);
+    }
+    return true;
+}
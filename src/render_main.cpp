@@ -0,0 +1,320 @@
+#include "brick_map.h"
+#include "cpu_renderer.h"
+#include "distance_clipmap.h"
+#include "distance_volume.h"
+#include "image_io.h"
+#include "packet_march.h"
+#include "render_job.h"
+
+#ifdef FRACTAL_HAVE_EGL
+#include "offscreen_context.h"
+#include "render_target.h"
+#include "shader_renderer.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+static void printUsage() {
+    std::cout << "Usage: fractal_render [options]\n"
+              << "  --job <file.json>       Render the frames described in a job file\n"
+              << "  --mantissa <x,y,z>      Camera mantissa (default 0,0,5)\n"
+              << "  --exponent <n>          Camera exponent, scale = 2^n (default -2)\n"
+              << "  --yaw <deg>             Camera yaw (default -90)\n"
+              << "  --pitch <deg>           Camera pitch (default 0)\n"
+              << "  --fov <deg>             Vertical field of view (default 45)\n"
+              << "  --size <WxH>            Output resolution (default 960x540)\n"
+              << "  --iterations <n>        maxIterations (default 16)\n"
+              << "  --time <t>              Value of the time uniform (default 0)\n"
+              << "  --auto-rotate           Enable the autoRotate uniform\n"
+              << "  --output <path>         Output image, .ppm or .pfm (default fractal.ppm)\n"
+              << "  --threads <n>           Worker threads (default: all cores)\n"
+              << "  --simd <level>          scalar, sse4.2, avx2 or avx512 (default: best available)\n"
+              << "  --relaxation <w>        Over-relaxed sphere tracing factor, 1 = plain (default 1)\n"
+              << "  --backend <cpu|gl>      CPU renderer or fragment.glsl in an offscreen EGL context (default cpu)\n"
+              << "  --volume <n>            Skip empty space with a cached n^3 distance volume, 0 = off (default 0)\n"
+              << "  --bricks <n>            The same with a sparse n^3 brick map, n a multiple of 8, 0 = off (default 0)\n"
+              << "  --symmetric             Store --volume and --bricks for 1/48 of the cube and fold lookups into it\n"
+              << "  --clipmap <n>           The same with n^3 camera-centred levels updated per frame, 0 = off (default 0)\n"
+              << "Options given on the command line are defaults for frames in the job file.\n";
+}
+
+static bool parseSimdLevel(const std::string& name, SimdLevel& level) {
+    if (name == "scalar") level = SimdLevel::Scalar;
+    else if (name == "sse4.2") level = SimdLevel::SSE42;
+    else if (name == "avx2") level = SimdLevel::AVX2;
+    else if (name == "avx512") level = SimdLevel::AVX512;
+    else return false;
+    return true;
+}
+
+// The highest iteration count of the job; a bound baked at it covers every
+// frame.
+static int jobIterations(const std::vector<FrameJob>& frames) {
+    int iterations = 1;
+    for (const FrameJob& frame : frames)
+        iterations = std::max(iterations, frame.maxIterations);
+    return iterations;
+}
+
+static bool loadVolume(const std::vector<FrameJob>& frames, int resolution, bool symmetric, unsigned threads,
+                       DistanceVolume& volume) {
+    ThreadPool pool(threads);
+    if (!volume.load(DistanceVolume::defaultDirectory(), resolution, jobIterations(frames), pool, symmetric)) {
+        std::cerr << "ERROR::VOLUME::NOT_LOADED" << std::endl;
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(volume.resolution());
+    std::cout << "Distance volume: " << sizeof(float) * volume.sampleCount() / 1024 << " KiB (dense "
+              << sizeof(float) * size * size * size / 1024 << " KiB)" << std::endl;
+    return true;
+}
+
+static bool loadBrickMap(const std::vector<FrameJob>& frames, int resolution, bool symmetric, unsigned threads,
+                         BrickMap& bricks) {
+    ThreadPool pool(threads);
+    int cells = resolution / BrickMap::BRICK_SIZE;
+    if (!bricks.load(DistanceVolume::defaultDirectory(), cells, jobIterations(frames), pool, symmetric)) {
+        std::cerr << "ERROR::BRICKS::NOT_LOADED" << std::endl;
+        return false;
+    }
+
+    // Against a dense float grid at the same resolution.
+    size_t dense = sizeof(float) * static_cast<size_t>(resolution) * resolution * resolution;
+    std::cout << "Brick map: " << bricks.brickCount() << " of " << bricks.cellBounds().size() << " cells bricked, "
+              << bricks.memoryBytes() / 1024 << " KiB (dense " << dense / 1024 << " KiB)" << std::endl;
+    return true;
+}
+
+// Brings the clipmap up to date around the frame's camera in one go; returns
+// the samples that took.
+static size_t updateClipmap(DistanceClipmap& clipmap, const ViewParams& view, ThreadPool& pool) {
+    return clipmap.update(toObjectSpace(view.camPos, view.fractal), std::max(1, view.fractal.maxIterations),
+                          SIZE_MAX, pool);
+}
+
+static int renderWithCPU(const std::vector<FrameJob>& frames, unsigned threads, float relaxation,
+                         const DistanceVolume& volume, const BrickMap& bricks, DistanceClipmap* clipmap) {
+    CpuRenderer renderer(threads);
+    renderer.Relaxation = relaxation;
+    if (!volume.empty())
+        renderer.Volume = &volume;
+    else if (!bricks.empty())
+        renderer.Volume = &bricks;
+    else if (clipmap)
+        renderer.Volume = clipmap;
+    std::unique_ptr<ThreadPool> clipmapPool;
+    if (clipmap)
+        clipmapPool = std::make_unique<ThreadPool>(threads);
+    std::cout << "Rendering " << frames.size() << " frame(s) on " << renderer.threadCount()
+              << " threads (" << simdLevelName(activeSimdLevel()) << ")" << std::endl;
+
+    std::vector<glm::vec3> pixels;
+    int failures = 0;
+    for (const FrameJob& frame : frames) {
+        ViewParams view = makeViewParams(frame);
+        auto start = std::chrono::steady_clock::now();
+        size_t clipmapSamples = clipmap ? updateClipmap(*clipmap, view, *clipmapPool) : 0;
+        renderer.render(view, pixels);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (!writeImage(frame.output, frame.width, frame.height, pixels)) {
+            failures++;
+            continue;
+        }
+        std::cout << frame.output << " (" << frame.width << "x" << frame.height << ", "
+                  << seconds * 1000.0 << " ms, " << renderer.evaluationsPerPixel()
+                  << " DE evaluations/pixel";
+        if (clipmap)
+            std::cout << ", " << clipmapSamples << " clipmap samples";
+        std::cout << ")" << std::endl;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
+
+static int renderWithGL(const std::vector<FrameJob>& frames, float relaxation, const DistanceVolume& volume,
+                        const BrickMap& bricks, DistanceClipmap* clipmap) {
+#ifdef FRACTAL_HAVE_EGL
+    OffscreenContext context;
+    if (!context.create())
+        return 1;
+
+    std::cout << "Rendering " << frames.size() << " frame(s) on " << context.renderer() << std::endl;
+
+    ShaderRenderer renderer;
+    renderer.Relaxation = relaxation;
+    if (!volume.empty())
+        renderer.setDistanceVolume(volume);
+    else if (!bricks.empty())
+        renderer.setBrickMap(bricks);
+    std::unique_ptr<ThreadPool> clipmapPool;
+    if (clipmap)
+        clipmapPool = std::make_unique<ThreadPool>();
+    RenderTarget target;
+    std::vector<glm::vec3> pixels;
+    int failures = 0;
+    for (const FrameJob& frame : frames) {
+        ViewParams view = makeViewParams(frame);
+        auto start = std::chrono::steady_clock::now();
+        if (clipmap) {
+            updateClipmap(*clipmap, view, *clipmapPool);
+            renderer.setClipmap(*clipmap);
+        }
+        if (!target.resize(frame.width, frame.height))
+            return 1;
+        target.bind();
+        renderer.draw(view);
+        target.readPixels(pixels);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (!writeImage(frame.output, frame.width, frame.height, pixels)) {
+            failures++;
+            continue;
+        }
+        std::cout << frame.output << " (" << frame.width << "x" << frame.height << ", "
+                  << seconds * 1000.0 << " ms)" << std::endl;
+    }
+
+    return failures == 0 ? 0 : 1;
+#else
+    (void)frames;
+    (void)relaxation;
+    (void)volume;
+    (void)bricks;
+    (void)clipmap;
+    std::cerr << "ERROR::BACKEND::GL_NOT_AVAILABLE: built without EGL" << std::endl;
+    return 1;
+#endif
+}
+
+int main(int argc, char** argv) {
+    FrameJob base;
+    const char* jobPath = nullptr;
+    unsigned threads = 0;
+    std::string backend = "cpu";
+    float relaxation = 1.0f;
+    int volumeResolution = 0;
+    int brickResolution = 0;
+    int clipmapSize = 0;
+    bool symmetric = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        const char* value = hasValue ? argv[i + 1] : "";
+
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else if (arg == "--auto-rotate") {
+            base.autoRotate = true;
+            continue;
+        } else if (arg == "--symmetric") {
+            symmetric = true;
+            continue;
+        } else if (!hasValue) {
+            std::cerr << "ERROR::ARGS::MISSING_VALUE: " << arg << std::endl;
+            return 1;
+        }
+
+        bool ok = true;
+        if (arg == "--job") {
+            jobPath = value;
+        } else if (arg == "--mantissa") {
+            ok = std::sscanf(value, "%f,%f,%f", &base.mantissa.x, &base.mantissa.y, &base.mantissa.z) == 3;
+        } else if (arg == "--exponent") {
+            base.exponent = std::atoi(value);
+        } else if (arg == "--yaw") {
+            base.yaw = static_cast<float>(std::atof(value));
+        } else if (arg == "--pitch") {
+            base.pitch = static_cast<float>(std::atof(value));
+        } else if (arg == "--fov") {
+            base.fov = static_cast<float>(std::atof(value));
+        } else if (arg == "--size") {
+            ok = std::sscanf(value, "%dx%d", &base.width, &base.height) == 2 &&
+                 base.width > 0 && base.height > 0;
+        } else if (arg == "--iterations") {
+            base.maxIterations = std::atoi(value);
+            ok = base.maxIterations >= 0;
+        } else if (arg == "--time") {
+            base.time = static_cast<float>(std::atof(value));
+        } else if (arg == "--output") {
+            base.output = value;
+        } else if (arg == "--threads") {
+            int n = std::atoi(value);
+            ok = n >= 0;
+            if (ok)
+                threads = static_cast<unsigned>(n);
+        } else if (arg == "--relaxation") {
+            relaxation = static_cast<float>(std::atof(value));
+            ok = relaxation >= 1.0f && relaxation < 2.0f;
+        } else if (arg == "--volume") {
+            volumeResolution = std::atoi(value);
+            ok = volumeResolution == 0 || volumeResolution >= 2;
+        } else if (arg == "--bricks") {
+            brickResolution = std::atoi(value);
+            ok = brickResolution >= 0 && brickResolution % BrickMap::BRICK_SIZE == 0;
+        } else if (arg == "--clipmap") {
+            clipmapSize = std::atoi(value);
+            ok = clipmapSize == 0 || clipmapSize >= 2;
+        } else if (arg == "--backend") {
+            backend = value;
+            ok = backend == "cpu" || backend == "gl";
+        } else if (arg == "--simd") {
+            SimdLevel level;
+            ok = parseSimdLevel(value, level);
+            if (ok)
+                setSimdLevel(level);
+        } else {
+            std::cerr << "ERROR::ARGS::UNKNOWN_OPTION: " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+
+        if (!ok) {
+            std::cerr << "ERROR::ARGS::INVALID_VALUE: " << arg << " " << value << std::endl;
+            return 1;
+        }
+        i++;
+    }
+
+    std::vector<FrameJob> frames;
+    if (jobPath) {
+        std::string error;
+        if (!loadJobFile(jobPath, base, frames, error)) {
+            std::cerr << "ERROR::JOB::INVALID_FILE: " << jobPath << ": " << error << std::endl;
+            return 1;
+        }
+    } else {
+        frames.push_back(base);
+    }
+
+    if ((volumeResolution > 0) + (brickResolution > 0) + (clipmapSize > 0) > 1) {
+        std::cerr << "ERROR::ARGS::CONFLICTING_OPTIONS: --volume, --bricks and --clipmap" << std::endl;
+        return 1;
+    }
+
+    DistanceVolume volume;
+    if (volumeResolution > 0 && !loadVolume(frames, volumeResolution, symmetric, threads, volume))
+        return 1;
+    BrickMap bricks;
+    if (brickResolution > 0 && !loadBrickMap(frames, brickResolution, symmetric, threads, bricks))
+        return 1;
+
+    std::unique_ptr<DistanceClipmap> clipmap;
+    if (clipmapSize > 0)
+        clipmap = std::make_unique<DistanceClipmap>(clipmapSize);
+
+    if (backend == "gl")
+        return renderWithGL(frames, relaxation, volume, bricks, clipmap.get());
+    return renderWithCPU(frames, threads, relaxation, volume, bricks, clipmap.get());
+}
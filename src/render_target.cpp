@@ -0,0 +1,109 @@
+#include "render_target.h"
+#include <algorithm>
+#include <iostream>
+
+// Upload format for an internal format; glTexStorage needs GL 4.2, macOS stops at 4.1.
+static void pixelTransferFormat(GLenum internalFormat, GLenum& format, GLenum& type) {
+    switch (internalFormat) {
+    case GL_R32F:
+    case GL_R16F:
+        format = GL_RED;
+        type = GL_FLOAT;
+        break;
+    case GL_RG32F:
+    case GL_RG16F:
+        format = GL_RG;
+        type = GL_FLOAT;
+        break;
+    case GL_RGBA8:
+        format = GL_RGBA;
+        type = GL_UNSIGNED_BYTE;
+        break;
+    default:
+        format = GL_RGBA;
+        type = GL_FLOAT;
+        break;
+    }
+}
+
+RenderTarget::~RenderTarget() {
+    release();
+}
+
+static GLuint createTexture(int width, int height, GLenum internalFormat) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    GLenum pixelFormat, pixelType;
+    pixelTransferFormat(internalFormat, pixelFormat, pixelType);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, pixelFormat, pixelType, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+void RenderTarget::release() {
+    if (Texture)
+        glDeleteTextures(1, &Texture);
+    if (ExtraTexture)
+        glDeleteTextures(1, &ExtraTexture);
+    if (FBO)
+        glDeleteFramebuffers(1, &FBO);
+    Texture = 0;
+    ExtraTexture = 0;
+    FBO = 0;
+}
+
+bool RenderTarget::resize(int width, int height, GLenum internalFormat, GLenum extra) {
+    if (FBO && width == Width && height == Height && internalFormat == format && extra == extraFormat)
+        return true;
+
+    release();
+    Width = width;
+    Height = height;
+    format = internalFormat;
+    extraFormat = extra;
+
+    glGenFramebuffers(1, &FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    Texture = createTexture(width, height, internalFormat);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Texture, 0);
+    if (extra != GL_NONE) {
+        ExtraTexture = createTexture(width, height, extra);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, ExtraTexture, 0);
+        const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, drawBuffers);
+    }
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR::FRAMEBUFFER::INCOMPLETE: 0x" << std::hex << status << std::dec << std::endl;
+        release();
+        return false;
+    }
+    return true;
+}
+
+void RenderTarget::bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glViewport(0, 0, Width, Height);
+}
+
+void RenderTarget::readPixels(std::vector<glm::vec3>& pixels) const {
+    std::vector<glm::vec3> rows(static_cast<size_t>(Width) * Height);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, Width, Height, GL_RGB, GL_FLOAT, rows.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    // GL rows start at the bottom of the image.
+    pixels.resize(rows.size());
+    for (int y = 0; y < Height; y++) {
+        const glm::vec3* src = &rows[static_cast<size_t>(Height - 1 - y) * Width];
+        std::copy(src, src + Width, &pixels[static_cast<size_t>(y) * Width]);
+    }
+}
@@ -0,0 +1,24 @@
+#include "resolution_controller.h"
+#include <algorithm>
+#include <cmath>
+
+// Within this ratio of the target the scale is left alone, so noise in the
+// timer does not make the image size breathe.
+static const double DEAD_BAND = 0.08;
+// Scale is kept on a 1/64 grid to avoid reallocating for sub-pixel changes.
+static const float SCALE_STEP = 1.0f / 64.0f;
+
+void ResolutionController::update(double measuredMs, float measuredScale) {
+    if (measuredMs <= 0.0 || measuredScale <= 0.0f)
+        return;
+
+    double ratio = TargetMs / measuredMs;
+    if (std::abs(ratio - 1.0) < DEAD_BAND)
+        return;
+
+    // Pixel count goes with the square of the scale.
+    float ideal = measuredScale * static_cast<float>(std::sqrt(ratio));
+    float next = current + (ideal - current) * Response;
+    next = std::round(next / SCALE_STEP) * SCALE_STEP;
+    current = std::clamp(next, MinScale, MaxScale);
+}
@@ -0,0 +1,111 @@
+#include "shader_preprocessor.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+static bool readText(const std::string& path, std::string& text) {
+    std::ifstream file(path);
+    if (!file)
+        return false;
+    std::stringstream stream;
+    stream << file.rdbuf();
+    text = stream.str();
+    return true;
+}
+
+static std::string directoryOf(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+// Returns the quoted file name of an #include line, or an empty string.
+static std::string includeTarget(const std::string& line) {
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+        return std::string();
+
+    size_t open = line.find('"', start + 8);
+    size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+    if (close == std::string::npos)
+        return std::string();
+    return line.substr(open + 1, close - open - 1);
+}
+
+static bool isVersionLine(const std::string& line) {
+    size_t start = line.find_first_not_of(" \t");
+    return start != std::string::npos && line.compare(start, 8, "#version") == 0;
+}
+
+struct ExpandState {
+    explicit ExpandState(const ShaderDefines& injected) : defines(injected) {}
+
+    const ShaderDefines& defines;
+    std::vector<std::string> stack;
+    int nextSourceNumber = 1;
+    std::string error;
+};
+
+static bool expand(const std::string& path, int sourceNumber, ExpandState& state, std::string& out) {
+    if (std::find(state.stack.begin(), state.stack.end(), path) != state.stack.end()) {
+        state.error = "recursive #include of " + path;
+        return false;
+    }
+
+    std::string text;
+    if (!readText(path, text)) {
+        state.error = "cannot read " + path;
+        return false;
+    }
+    state.stack.push_back(path);
+
+    std::istringstream lines(text);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line)) {
+        lineNumber++;
+
+        std::string target = includeTarget(line);
+        if (!target.empty()) {
+            int includedNumber = state.nextSourceNumber++;
+            out += "#line 1 " + std::to_string(includedNumber) + "\n";
+            if (!expand(directoryOf(path) + target, includedNumber, state, out))
+                return false;
+            out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceNumber) + "\n";
+            continue;
+        }
+
+        out += line;
+        out += '\n';
+
+        if (sourceNumber == 0 && isVersionLine(line)) {
+            for (const auto& define : state.defines)
+                out += "#define " + define.first + " " + define.second + "\n";
+            out += "#line " + std::to_string(lineNumber + 1) + " 0\n";
+        }
+    }
+
+    state.stack.pop_back();
+    return true;
+}
+
+bool preprocessShader(const std::string& path, const ShaderDefines& defines,
+                      std::string& source, std::string& error) {
+    ExpandState state(defines);
+    source.clear();
+    if (!expand(path, 0, state, source)) {
+        error = state.error;
+        return false;
+    }
+    return true;
+}
+
+std::string describeDefines(const ShaderDefines& defines) {
+    std::string text;
+    for (const auto& define : defines) {
+        if (!text.empty())
+            text += ' ';
+        text += define.first + "=" + define.second;
+    }
+    return text.empty() ? "default" : text;
+}
@@ -0,0 +1,630 @@
+#include "shader_renderer.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+static const GLuint FRAME_UNIFORMS_BINDING = 0;
+
+// Texture units of the intermediate passes.
+static const int PREPASS_UNIT = 0;
+static const int REPROJECTED_UNIT = 1;
+static const int PREVIOUS_DEPTH_UNIT = 2;
+static const int ACCUMULATION_UNIT = 3;
+static const int DISTANCE_VOLUME_UNIT = 4;
+static const int BRICK_INDEX_UNIT = 5;
+static const int BRICK_ATLAS_UNIT = 6;
+static const int CLIPMAP_LEVELS_UNIT = 7;
+static const int CLIPMAP_BOXES_UNIT = 8;
+
+// Bricks along the atlas's x and y before further ones stack along z. Both
+// grow up to GL_MAX_3D_TEXTURE_SIZE when the stack would outgrow it.
+static const int ATLAS_BRICKS = 32;
+
+// Must match REPROJECT_EMPTY in fragment.glsl.
+static const float REPROJECT_EMPTY = 1e9f;
+
+// Sub-pixel offset of accumulated sample n, from the (2, 3) Halton sequence
+// centred on the pixel. Sample 0 is the centre, as drawn without accumulation.
+static float halton(int index, int base) {
+    float f = 1.0f;
+    float result = 0.0f;
+    while (index > 0) {
+        f /= static_cast<float>(base);
+        result += f * static_cast<float>(index % base);
+        index /= base;
+    }
+    return result;
+}
+
+static glm::vec2 sampleJitter(int sample) {
+    if (sample == 0)
+        return glm::vec2(0.0f);
+    return glm::vec2(halton(sample, 2), halton(sample, 3)) - 0.5f;
+}
+
+static_assert(sizeof(FrameUniforms) == 80, "FrameUniforms must match the std140 block layout");
+
+// Shown while the real program links in the background.
+static const char* PLACEHOLDER_VERTEX = R"(#version 410 core
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aTexCoord;
+out vec2 TexCoord;
+
+void main() {
+    gl_Position = vec4(aPos, 0.0, 1.0);
+    TexCoord = aTexCoord;
+}
+)";
+
+static const char* PLACEHOLDER_FRAGMENT = R"(#version 410 core
+in vec2 TexCoord;
+out vec4 FragColor;
+
+void main() {
+    FragColor = vec4(mix(vec3(0.02, 0.02, 0.04), vec3(0.08, 0.09, 0.14), TexCoord.y), 1.0);
+}
+)";
+
+ShaderRenderer::ShaderRenderer(const char* vertexPath, const char* fragmentPath, bool asyncCompile)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath), asyncCompile(asyncCompile),
+      programs(makePrograms()) {
+    float quadVertices[] = {
+        -1.0f,  1.0f,  0.0f, 1.0f,
+        -1.0f, -1.0f,  0.0f, 0.0f,
+         1.0f, -1.0f,  1.0f, 0.0f,
+
+        -1.0f,  1.0f,  0.0f, 1.0f,
+         1.0f, -1.0f,  1.0f, 0.0f,
+         1.0f,  1.0f,  1.0f, 1.0f
+    };
+
+    glGenVertexArrays(1, &quadVAO);
+    glGenBuffers(1, &quadVBO);
+    glBindVertexArray(quadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+
+    if (asyncCompile && !generic().ready())
+        placeholder = Shader::fromSource(PLACEHOLDER_VERTEX, PLACEHOLDER_FRAGMENT);
+}
+
+ShaderRenderer::~ShaderRenderer() {
+    glDeleteVertexArrays(1, &quadVAO);
+    glDeleteBuffers(1, &quadVBO);
+    GLuint textures[] = { volumeTexture, brickIndexTexture, brickAtlasTexture, clipmapTexture, clipmapBoxTexture };
+    for (GLuint texture : textures) {
+        if (texture)
+            glDeleteTextures(1, &texture);
+    }
+}
+
+// Nearest-sample 3D texture, read with texelFetch.
+static void uploadTexture3D(GLuint& texture, GLenum internalFormat, int width, int height, int depth,
+                            GLenum format, GLenum type, const void* data) {
+    if (!texture)
+        glGenTextures(1, &texture);
+
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_3D, 0, internalFormat, width, height, depth, 0, format, type, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+}
+
+// Entry of octant texel t in a symmetric bake: the one its fold lands on.
+static glm::ivec3 foldTexel(glm::ivec3 t) {
+    glm::vec3 f = symmetryFold(glm::vec3(t));
+    return glm::ivec3(f);
+}
+
+void ShaderRenderer::setDistanceVolume(const DistanceVolume& volume) {
+    // Read from the nearest sample, as lowerBound() does. A symmetric bake is
+    // unpacked to the octant, so the shader indexes it like a grid.
+    if (volume.symmetric()) {
+        int half = volume.halfResolution();
+        std::vector<float> octant(static_cast<size_t>(half) * half * half);
+        for (size_t i = 0; i < octant.size(); i++) {
+            glm::ivec3 t = foldTexel(glm::ivec3(i % half, (i / half) % half, i / (static_cast<size_t>(half) * half)));
+            octant[i] = volume.data()[DistanceVolume::wedgeIndex(t.x, t.y, t.z)];
+        }
+        uploadTexture3D(volumeTexture, GL_R32F, half, half, half, GL_RED, GL_FLOAT, octant.data());
+    } else {
+        int size = volume.resolution();
+        uploadTexture3D(volumeTexture, GL_R32F, size, size, size, GL_RED, GL_FLOAT, volume.data());
+    }
+
+    skipVolume = 1;
+    skipSymmetric = volume.symmetric();
+    skipIterations = volume.iterations();
+    volumeCell = volume.cellSize();
+}
+
+void ShaderRenderer::setBrickMap(const BrickMap& bricks) {
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+    const int size = BrickMap::BRICK_SIZE;
+    const int limit = maxSize / size;
+    int count = std::max(bricks.brickCount(), 1);
+    int across = std::min(ATLAS_BRICKS, limit);
+    while (across < limit && (count + across * across - 1) / (across * across) > limit)
+        across = std::min(across * 2, limit);
+    int w = std::min(count, across);
+    int h = std::min((count + w - 1) / w, across);
+    int d = (count + w * h - 1) / (w * h);
+
+    // A symmetric map's index is unpacked to the octant.
+    int cells = bricks.indexCells();
+    if (cells > maxSize || d > limit) {
+        std::cerr << "ERROR::BRICKS::ATLAS_TOO_LARGE: " << cells << "^3 cells with " << bricks.brickCount()
+                  << " bricks exceed GL_MAX_3D_TEXTURE_SIZE " << maxSize << "; not skipping empty space"
+                  << std::endl;
+        skipVolume = 0;
+        return;
+    }
+    const std::vector<float>& bounds = bricks.cellBounds();
+    const std::vector<int32_t>& indices = bricks.brickIndices();
+    std::vector<glm::vec2> index(static_cast<size_t>(cells) * cells * cells);
+    for (size_t i = 0; i < index.size(); i++) {
+        glm::ivec3 c(i % cells, (i / cells) % cells, i / (static_cast<size_t>(cells) * cells));
+        size_t entry = bricks.cellIndex(bricks.symmetric() ? foldTexel(c) : c);
+        index[i] = glm::vec2(bounds[entry], static_cast<float>(indices[entry]));
+    }
+    uploadTexture3D(brickIndexTexture, GL_RG32F, cells, cells, cells, GL_RG, GL_FLOAT, index.data());
+
+    // Brick b sits at (b % w, (b / w) % h, b / (w * h)) in brick units.
+    std::vector<uint8_t> atlas(static_cast<size_t>(w) * h * d * size * size * size, 0);
+    const std::vector<uint8_t>& data = bricks.brickData();
+    for (int b = 0; b < bricks.brickCount(); b++) {
+        glm::ivec3 origin = glm::ivec3(b % w, (b / w) % h, b / (w * h)) * size;
+        for (int z = 0; z < size; z++) {
+            for (int y = 0; y < size; y++) {
+                size_t from = ((static_cast<size_t>(b) * size + z) * size + y) * size;
+                size_t to = ((static_cast<size_t>(origin.z + z) * h * size + origin.y + y) * w * size) + origin.x;
+                std::memcpy(&atlas[to], &data[from], size);
+            }
+        }
+    }
+    uploadTexture3D(brickAtlasTexture, GL_R8, w * size, h * size, d * size, GL_RED, GL_UNSIGNED_BYTE, atlas.data());
+
+    skipVolume = 2;
+    skipIterations = bricks.iterations();
+    skipSymmetric = bricks.symmetric();
+}
+
+void ShaderRenderer::setClipmap(const DistanceClipmap& clipmap) {
+    const int levels = DistanceClipmap::LEVELS;
+    int size = clipmap.size();
+    if (size != clipmapSize) {
+        uploadTexture3D(clipmapTexture, GL_R32F, size, size, size * levels, GL_RED, GL_FLOAT, nullptr);
+        clipmapSize = size;
+        for (uint64_t& version : clipmapVersions)
+            version = ~0ull;
+    }
+
+    // Whole levels are sent when they change: 128 KiB at 32^3, little next to
+    // tracking which toroidal slabs moved.
+    glBindTexture(GL_TEXTURE_3D, clipmapTexture);
+    for (int l = 0; l < levels; l++) {
+        if (clipmap.levelVersion(l) == clipmapVersions[l])
+            continue;
+        glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, l * size, size, size, size, GL_RED, GL_FLOAT, clipmap.levelData(l));
+        clipmapVersions[l] = clipmap.levelVersion(l);
+    }
+
+    glm::vec4 boxes[2 * levels];
+    for (int l = 0; l < levels; l++) {
+        boxes[2 * l] = glm::vec4(glm::vec3(clipmap.validMin(l)), clipmap.voxelSize(l));
+        boxes[2 * l + 1] = glm::vec4(glm::vec3(clipmap.validMax(l)), 0.0f);
+    }
+    if (!clipmapBoxTexture) {
+        glGenTextures(1, &clipmapBoxTexture);
+        glBindTexture(GL_TEXTURE_2D, clipmapBoxTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glBindTexture(GL_TEXTURE_2D, clipmapBoxTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, 2, levels, 0, GL_RGBA, GL_FLOAT, boxes);
+
+    skipVolume = 3;
+    skipIterations = clipmap.iterations();
+    skipSymmetric = false;
+}
+
+std::unique_ptr<ShaderRenderer::ProgramSet> ShaderRenderer::makePrograms() {
+    size_t slash = fragmentPath.find_last_of("/\\");
+
+    std::string directory = fragmentPath.substr(0, slash == std::string::npos ? 0 : slash + 1);
+    std::string prepassPath = directory + "depth_prepass.glsl";
+    std::string reprojectVertex = directory + "reproject_vertex.glsl";
+    std::string reprojectFragment = directory + "reproject_fragment.glsl";
+    std::string resolvePath = directory + "accumulate_resolve.glsl";
+
+    auto set = std::make_unique<ProgramSet>();
+    set->Fractal = std::make_unique<ShaderVariants>(vertexPath.c_str(), fragmentPath.c_str(), asyncCompile);
+    set->Prepass = std::make_unique<ShaderVariants>(vertexPath.c_str(), prepassPath.c_str(), asyncCompile);
+    set->Reproject = std::make_unique<ShaderVariants>(reprojectVertex.c_str(), reprojectFragment.c_str(), asyncCompile);
+    set->Resolve = std::make_unique<ShaderVariants>(vertexPath.c_str(), resolvePath.c_str(), asyncCompile);
+    for (ShaderVariants* variants : { set->Fractal.get(), set->Prepass.get(), set->Reproject.get() })
+        variants->OnEvict = [this](const Shader& program) { bindings.erase(&program); };
+    set->Fractal->get(ShaderDefines());
+    return set;
+}
+
+Shader& ShaderRenderer::generic() {
+    return programs->Fractal->get(ShaderDefines());
+}
+
+Shader* ShaderRenderer::selectVariant(ShaderVariants& variants, const ViewParams& view) {
+    if (SpecializeVariants) {
+        Shader& specialized = variants.get(variantDefines(view));
+        if (specialized.ready() && specialized.linked())
+            return &specialized;
+    }
+    Shader& fallback = variants.get(ShaderDefines());
+    return fallback.ready() && fallback.linked() ? &fallback : nullptr;
+}
+
+bool ShaderRenderer::ready() {
+    if (placeholder && generic().ready())
+        placeholder.reset();
+    return !placeholder;
+}
+
+void ShaderRenderer::waitUntilReady(const ViewParams& view) {
+    ShaderDefines defines = SpecializeVariants ? variantDefines(view) : ShaderDefines();
+    programs->Fractal->get(defines).wait();
+    if (PrepassTile > 0)
+        programs->Prepass->get(defines).wait();
+    if (TemporalFraction > 0.0f)
+        programs->Reproject->get(defines).wait();
+    if (AccumulationSamples > 0)
+        programs->Resolve->get(ShaderDefines()).wait();
+    ready();
+}
+
+void ShaderRenderer::reload() {
+    reloading = makePrograms();
+    reloading->Prepass->get(ShaderDefines());
+    reloading->Reproject->get(ShaderDefines());
+    reloading->Resolve->get(ShaderDefines());
+}
+
+void ShaderRenderer::finishReload() {
+    Shader& fractal = reloading->Fractal->get(ShaderDefines());
+    Shader& prepass = reloading->Prepass->get(ShaderDefines());
+    Shader& reproject = reloading->Reproject->get(ShaderDefines());
+    Shader& resolve = reloading->Resolve->get(ShaderDefines());
+    if (!fractal.ready() || !prepass.ready() || !reproject.ready() || !resolve.ready())
+        return;
+
+    if (fractal.linked() && prepass.linked() && reproject.linked() && resolve.linked()) {
+        // Bindings are keyed by program and die with the old set.
+        bindings.clear();
+        accumulated = 0;
+        programs.swap(reloading);
+        placeholder.reset();
+        std::cout << "Shaders reloaded" << std::endl;
+    } else {
+        std::cerr << "ERROR::SHADER::RELOAD_FAILED: keeping the previous program" << std::endl;
+    }
+    reloading.reset();
+}
+
+ShaderDefines ShaderRenderer::variantDefines(const ViewParams& view) {
+    ShaderDefines defines;
+    defines["MAX_ITERATIONS"] = std::to_string(view.fractal.maxIterations);
+    defines["AUTO_ROTATE"] = view.fractal.autoRotate ? "1" : "0";
+    return defines;
+}
+
+bool ShaderRenderer::sameImage(const ViewParams& a, const ViewParams& b) {
+    return a.camPos == b.camPos && a.camFront == b.camFront && a.camRight == b.camRight &&
+           a.camUp == b.camUp && a.fov == b.fov && a.width == b.width && a.height == b.height &&
+           a.fractal.maxIterations == b.fractal.maxIterations && a.fractal.scale == b.fractal.scale &&
+           a.fractal.time == b.fractal.time && a.fractal.autoRotate == b.fractal.autoRotate;
+}
+
+ShaderRenderer::FrameBindings& ShaderRenderer::bindingsFor(const Shader& program) {
+    auto it = bindings.find(&program);
+    if (it != bindings.end())
+        return it->second;
+
+    FrameBindings& frame = bindings[&program];
+    frame.UsesBlock = program.bindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
+    if (frame.UsesBlock) {
+        if (!frameRing)
+            frameRing = std::make_unique<UniformRing>(sizeof(FrameUniforms), FRAME_UNIFORMS_BINDING);
+    } else {
+        frame.camPos = program.uniform<glm::vec3>("camPos");
+        frame.camFront = program.uniform<glm::vec3>("camFront");
+        frame.camRight = program.uniform<glm::vec3>("camRight");
+        frame.camUp = program.uniform<glm::vec3>("camUp");
+        frame.resolution = program.uniform<glm::vec3>("resolution");
+        frame.fov = program.uniform<float>("fov");
+        frame.time = program.uniform<float>("time");
+        frame.scale = program.uniform<float>("scale");
+        frame.maxIterations = program.uniform<int>("maxIterations");
+        frame.autoRotate = program.uniform<bool>("autoRotate");
+    }
+    frame.prepassTile = program.uniform<int>("prepassTile");
+    frame.prepassDepth = program.uniform<int>("prepassDepth");
+    frame.reprojectedDepth = program.uniform<int>("reprojectedDepth");
+    frame.temporalFraction = program.uniform<float>("temporalFraction");
+    frame.relaxation = program.uniform<float>("relaxation");
+    frame.previousDepth = program.uniform<int>("previousDepth");
+    frame.previousCamPos = program.uniform<glm::vec3>("previousCamPos");
+    frame.previousCamFront = program.uniform<glm::vec3>("previousCamFront");
+    frame.previousCamRight = program.uniform<glm::vec3>("previousCamRight");
+    frame.previousCamUp = program.uniform<glm::vec3>("previousCamUp");
+    frame.previousFov = program.uniform<float>("previousFov");
+    frame.previousScale = program.uniform<float>("previousScale");
+    frame.previousTime = program.uniform<float>("previousTime");
+    frame.jitter = program.uniform<glm::vec2>("jitter");
+    frame.linearOutput = program.uniform<bool>("linearOutput");
+    frame.accumulation = program.uniform<int>("accumulation");
+    frame.skipVolume = program.uniform<int>("skipVolume");
+    frame.skipSymmetric = program.uniform<bool>("skipSymmetric");
+    frame.distanceVolume = program.uniform<int>("distanceVolume");
+    frame.volumeCell = program.uniform<float>("volumeCell");
+    frame.brickIndex = program.uniform<int>("brickIndex");
+    frame.brickAtlas = program.uniform<int>("brickAtlas");
+    frame.clipmapLevels = program.uniform<int>("clipmapLevels");
+    frame.clipmapBoxes = program.uniform<int>("clipmapBoxes");
+    return frame;
+}
+
+void ShaderRenderer::setUniforms(FrameBindings& frame, const ViewParams& view) {
+    if (!frame.UsesBlock) {
+        frame.camPos.set(view.camPos);
+        frame.camFront.set(view.camFront);
+        frame.camRight.set(view.camRight);
+        frame.camUp.set(view.camUp);
+        frame.fov.set(view.fov);
+        frame.time.set(view.fractal.time);
+        frame.scale.set(view.fractal.scale);
+        frame.resolution.set(glm::vec3(view.width, view.height, 0.0f));
+        frame.maxIterations.set(view.fractal.maxIterations);
+        frame.autoRotate.set(view.fractal.autoRotate);
+        return;
+    }
+
+    FrameUniforms block;
+    std::memset(&block, 0, sizeof(block));
+    block.camPos = view.camPos;
+    block.fov = view.fov;
+    block.camFront = view.camFront;
+    block.time = view.fractal.time;
+    block.camRight = view.camRight;
+    block.scale = view.fractal.scale;
+    block.camUp = view.camUp;
+    block.maxIterations = view.fractal.maxIterations;
+    block.resolution = glm::vec3(view.width, view.height, 0.0f);
+    block.autoRotate = view.fractal.autoRotate ? 1 : 0;
+
+    if (!frameWritten || std::memcmp(&block, &lastFrame, sizeof(block)) != 0) {
+        frameRing->write(&block);
+        lastFrame = block;
+        frameWritten = true;
+    }
+}
+
+// The previous frame's depths only bound the current surface when the
+// fractal itself is unchanged; camera motion and zoom are reprojected.
+bool ShaderRenderer::historyUsable(const ViewParams& view) const {
+    return hasHistory &&
+           previousView.width == view.width && previousView.height == view.height &&
+           previousView.fractal.maxIterations == view.fractal.maxIterations &&
+           previousView.fractal.autoRotate == view.fractal.autoRotate;
+}
+
+bool ShaderRenderer::runPrepass(Shader& prepass, const ViewParams& view) {
+    int tilesX = (view.width + PrepassTile - 1) / PrepassTile;
+    int tilesY = (view.height + PrepassTile - 1) / PrepassTile;
+    if (!prepassTarget.resize(tilesX, tilesY, GL_RG32F))
+        return false;
+
+    prepassTarget.bind();
+    prepass.use();
+    FrameBindings& frame = bindingsFor(prepass);
+    setUniforms(frame, view);
+    frame.prepassTile.set(PrepassTile);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    glActiveTexture(GL_TEXTURE0 + PREPASS_UNIT);
+    glBindTexture(GL_TEXTURE_2D, prepassTarget.Texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return true;
+}
+
+bool ShaderRenderer::runReprojection(Shader& reproject, const ViewParams& view) {
+    if (!reprojectTarget.resize(view.width, view.height, GL_RG32F))
+        return false;
+
+    reprojectTarget.bind();
+    const GLfloat empty[] = { REPROJECT_EMPTY, REPROJECT_EMPTY, 0.0f, 0.0f };
+    glClearBufferfv(GL_COLOR, 0, empty);
+
+    glActiveTexture(GL_TEXTURE0 + PREVIOUS_DEPTH_UNIT);
+    glBindTexture(GL_TEXTURE_2D, sceneTargets[sceneIndex ^ 1].ExtraTexture);
+
+    reproject.use();
+    FrameBindings& frame = bindingsFor(reproject);
+    setUniforms(frame, view);
+    frame.previousDepth.set(PREVIOUS_DEPTH_UNIT);
+    frame.previousCamPos.set(previousView.camPos);
+    frame.previousCamFront.set(previousView.camFront);
+    frame.previousCamRight.set(previousView.camRight);
+    frame.previousCamUp.set(previousView.camUp);
+    frame.previousFov.set(previousView.fov);
+    frame.previousScale.set(previousView.fractal.scale);
+    frame.previousTime.set(previousView.fractal.time);
+
+    // One point per previous pixel; overlapping points keep the nearest depth.
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_MIN);
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glDrawArrays(GL_POINTS, 0, view.width * view.height);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+    glBlendEquation(GL_FUNC_ADD);
+    glDisable(GL_BLEND);
+
+    glActiveTexture(GL_TEXTURE0 + REPROJECTED_UNIT);
+    glBindTexture(GL_TEXTURE_2D, reprojectTarget.Texture);
+    return true;
+}
+
+void ShaderRenderer::resolveAccumulation(Shader& resolve, GLint target, const ViewParams& view) {
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    glViewport(0, 0, view.width, view.height);
+
+    glActiveTexture(GL_TEXTURE0 + ACCUMULATION_UNIT);
+    glBindTexture(GL_TEXTURE_2D, accumulationTarget.Texture);
+
+    resolve.use();
+    bindingsFor(resolve).accumulation.set(ACCUMULATION_UNIT);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+}
+
+void ShaderRenderer::draw(const ViewParams& view) {
+    glViewport(0, 0, view.width, view.height);
+    glBindVertexArray(quadVAO);
+
+    if (reloading)
+        finishReload();
+
+    if (!ready()) {
+        placeholder->use();
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        return;
+    }
+
+    Shader* program = selectVariant(*programs->Fractal, view);
+    if (!program)
+        program = &generic();
+
+    Shader* resolve = nullptr;
+    if (AccumulationSamples > 0) {
+        Shader& candidate = programs->Resolve->get(ShaderDefines());
+        if (candidate.ready() && candidate.linked() &&
+            accumulationTarget.resize(view.width, view.height, GL_RGBA32F))
+            resolve = &candidate;
+    }
+    bool accumulate = resolve != nullptr;
+    if (!accumulate || !sameImage(view, accumulatedView))
+        accumulated = 0;
+    accumulatedView = view;
+
+    GLint target = 0;
+    if (accumulate && accumulated >= AccumulationSamples) {
+        // Converged: the image only needs presenting again.
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+        resolveAccumulation(*resolve, target, view);
+        return;
+    }
+
+    Shader* prepass = PrepassTile > 0 ? selectVariant(*programs->Prepass, view) : nullptr;
+    bool temporal = !accumulate && TemporalFraction > 0.0f;
+    Shader* reproject = temporal && historyUsable(view) ? selectVariant(*programs->Reproject, view) : nullptr;
+
+    if (prepass || temporal || accumulate)
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+
+    if (prepass && !runPrepass(*prepass, view))
+        prepass = nullptr;
+    if (reproject && !runReprojection(*reproject, view))
+        reproject = nullptr;
+
+    RenderTarget* scene = nullptr;
+    if (temporal && sceneTargets[sceneIndex].resize(view.width, view.height, GL_RGBA32F, GL_RG32F))
+        scene = &sceneTargets[sceneIndex];
+
+    if (scene) {
+        scene->bind();
+    } else if (accumulate) {
+        accumulationTarget.bind();
+    } else if (prepass || reproject) {
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+        glViewport(0, 0, view.width, view.height);
+    }
+
+    program->use();
+    FrameBindings& frame = bindingsFor(*program);
+    setUniforms(frame, view);
+    frame.prepassDepth.set(PREPASS_UNIT);
+    frame.prepassTile.set(prepass ? PrepassTile : 0);
+    frame.reprojectedDepth.set(REPROJECTED_UNIT);
+    frame.temporalFraction.set(reproject ? TemporalFraction : 0.0f);
+    frame.relaxation.set(Relaxation);
+    frame.jitter.set(accumulate ? sampleJitter(accumulated) : glm::vec2(0.0f));
+    frame.linearOutput.set(accumulate);
+
+    // Same condition as DistanceBound::covers().
+    bool skip = skipVolume != 0 && view.fractal.maxIterations >= 1 &&
+                view.fractal.maxIterations <= skipIterations;
+    if (skip && skipVolume == 1) {
+        glActiveTexture(GL_TEXTURE0 + DISTANCE_VOLUME_UNIT);
+        glBindTexture(GL_TEXTURE_3D, volumeTexture);
+    } else if (skip && skipVolume == 2) {
+        glActiveTexture(GL_TEXTURE0 + BRICK_INDEX_UNIT);
+        glBindTexture(GL_TEXTURE_3D, brickIndexTexture);
+        glActiveTexture(GL_TEXTURE0 + BRICK_ATLAS_UNIT);
+        glBindTexture(GL_TEXTURE_3D, brickAtlasTexture);
+    } else if (skip) {
+        glActiveTexture(GL_TEXTURE0 + CLIPMAP_LEVELS_UNIT);
+        glBindTexture(GL_TEXTURE_3D, clipmapTexture);
+        glActiveTexture(GL_TEXTURE0 + CLIPMAP_BOXES_UNIT);
+        glBindTexture(GL_TEXTURE_2D, clipmapBoxTexture);
+    }
+    frame.skipVolume.set(skip ? skipVolume : 0);
+    frame.skipSymmetric.set(skipSymmetric);
+    frame.distanceVolume.set(DISTANCE_VOLUME_UNIT);
+    frame.volumeCell.set(volumeCell);
+    frame.brickIndex.set(BRICK_INDEX_UNIT);
+    frame.brickAtlas.set(BRICK_ATLAS_UNIT);
+    frame.clipmapLevels.set(CLIPMAP_LEVELS_UNIT);
+    frame.clipmapBoxes.set(CLIPMAP_BOXES_UNIT);
+
+    // Running mean: sample n is blended in with weight 1 / (n + 1). The
+    // first replaces whatever the target held.
+    bool blend = accumulate && accumulated > 0;
+    if (blend) {
+        glEnable(GL_BLEND);
+        glBlendColor(0.0f, 0.0f, 0.0f, 1.0f / static_cast<float>(accumulated + 1));
+        glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+    }
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    if (blend) {
+        glBlendFunc(GL_ONE, GL_ZERO);
+        glDisable(GL_BLEND);
+    }
+
+    if (accumulate) {
+        accumulated++;
+        resolveAccumulation(*resolve, target, view);
+    }
+
+    hasHistory = scene != nullptr;
+    if (scene) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, scene->FBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+        glBlitFramebuffer(0, 0, view.width, view.height, 0, 0, view.width, view.height,
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+
+        previousView = view;
+        sceneIndex ^= 1;
+    }
+
+    if (frameRing)
+        frameRing->fence();
+}
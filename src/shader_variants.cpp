@@ -0,0 +1,30 @@
+#include "shader_variants.h"
+
+ShaderVariants::ShaderVariants(const char* vertexPath, const char* fragmentPath, bool async)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath), async(async) {}
+
+Shader& ShaderVariants::get(const ShaderDefines& defines) {
+    Variant& variant = programs[defines];
+    variant.lastUse = ++uses;
+    if (!variant.program) {
+        variant.program = std::make_unique<Shader>(vertexPath.c_str(), fragmentPath.c_str(), async, defines);
+        evictLeastRecent();
+    }
+    return *variant.program;
+}
+
+// The variant just asked for is the most recent, so it always survives.
+void ShaderVariants::evictLeastRecent() {
+    bool hasDefault = programs.count(ShaderDefines()) != 0;
+    if (programs.size() - (hasDefault ? 1 : 0) <= Capacity)
+        return;
+
+    auto oldest = programs.end();
+    for (auto it = programs.begin(); it != programs.end(); ++it) {
+        if (!it->first.empty() && (oldest == programs.end() || it->second.lastUse < oldest->second.lastUse))
+            oldest = it;
+    }
+    if (OnEvict)
+        OnEvict(*oldest->second.program);
+    programs.erase(oldest);
+}
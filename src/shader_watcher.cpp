@@ -0,0 +1,89 @@
+#include "shader_watcher.h"
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static const std::chrono::milliseconds SETTLE_TIME(150);
+static const std::chrono::milliseconds SCAN_INTERVAL(250);
+
+ShaderWatcher::ShaderWatcher(const std::string& directory) : directory(directory) {
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0 &&
+        inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE) < 0) {
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
+#endif
+    if (inotifyFd < 0)
+        scanModified();
+    lastScan = Clock::now();
+}
+
+ShaderWatcher::~ShaderWatcher() {
+#ifdef __linux__
+    if (inotifyFd >= 0)
+        close(inotifyFd);
+#endif
+}
+
+bool ShaderWatcher::poll() {
+    Clock::time_point now = Clock::now();
+
+    bool changed = false;
+    if (inotifyFd >= 0) {
+        changed = readEvents();
+    } else if (now - lastScan >= SCAN_INTERVAL) {
+        changed = scanModified();
+        lastScan = now;
+    }
+
+    if (changed) {
+        pending = true;
+        lastChange = now;
+    }
+
+    if (pending && now - lastChange >= SETTLE_TIME) {
+        pending = false;
+        return true;
+    }
+    return false;
+}
+
+bool ShaderWatcher::readEvents() {
+    bool changed = false;
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (char* p = buffer; p < buffer + length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+            // Ignore editor swap and backup files.
+            std::string name = event->len ? event->name : "";
+            if (!name.empty() && name[0] != '.' && name.back() != '~')
+                changed = true;
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+#endif
+    return changed;
+}
+
+bool ShaderWatcher::scanModified() {
+    std::error_code error;
+    std::map<std::string, std::filesystem::file_time_type> current;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.is_regular_file(error))
+            current[entry.path().string()] = entry.last_write_time(error);
+    }
+
+    bool changed = !modified.empty() && current != modified;
+    modified.swap(current);
+    return changed;
+}
@@ -0,0 +1,177 @@
+#include "shading.h"
+#include <algorithm>
+#include <cmath>
+
+glm::vec3 calcNormal(const glm::vec3& p, float eps, const FractalParams& params) {
+    float iterations = iterationLod(eps, params);
+    float trap;
+
+    glm::vec2 e(eps, 0.0f);
+    glm::vec3 exyy(e.x, e.y, e.y), eyxy(e.y, e.x, e.y), eyyx(e.y, e.y, e.x);
+    return glm::normalize(glm::vec3(
+        sceneSDF(p + exyy, params, iterations, trap) - sceneSDF(p - exyy, params, iterations, trap),
+        sceneSDF(p + eyxy, params, iterations, trap) - sceneSDF(p - eyxy, params, iterations, trap),
+        sceneSDF(p + eyyx, params, iterations, trap) - sceneSDF(p - eyyx, params, iterations, trap)
+    ));
+}
+
+float calcSoftShadow(const glm::vec3& ro, const glm::vec3& rd, float mint, float maxt,
+                     const FractalParams& params) {
+    float res = 1.0f;
+    float t = mint;
+    float trap;
+
+    for (int i = 0; i < 4; i++) {
+        float h = sceneSDF(ro + rd * t, params, trap);
+
+        if (h < 0.001f) {
+            return 0.0f;
+        }
+
+        res = std::min(res, 8.0f * h / t);
+        t += h;
+
+        if (t > maxt) {
+            break;
+        }
+    }
+
+    return glm::clamp(res, 0.0f, 1.0f);
+}
+
+float calcAO(const glm::vec3& p, const glm::vec3& n, const FractalParams& params) {
+    float occ = 0.0f;
+    float sca = 1.0f;
+    float trap;
+
+    for (int i = 0; i < 3; i++) {
+        float h = 0.001f + 0.15f * float(i) / 4.0f;
+        float d = sceneSDF(p + h * n, params, trap);
+        occ += (h - d) * sca;
+        sca *= 0.95f;
+
+        if (d < 0.0f) break;
+    }
+
+    return glm::clamp(1.0f - 2.5f * occ, 0.0f, 1.0f);
+}
+
+glm::vec3 getColor(const glm::vec3& p, const glm::vec3& normal, float orbitTrap) {
+    float t = glm::clamp(orbitTrap * 0.5f, 0.0f, 1.0f);
+
+    glm::vec3 col1(0.1f, 0.5f, 0.9f); // Bright blue
+    glm::vec3 col2(0.9f, 0.3f, 0.5f); // Pink-red
+    glm::vec3 col3(0.2f, 0.9f, 0.6f); // Cyan-green
+    glm::vec3 col4(0.9f, 0.7f, 0.2f); // Orange-yellow
+    glm::vec3 col5(0.6f, 0.2f, 0.9f); // Purple
+
+    glm::vec3 baseColor;
+    if (t < 0.2f) {
+        baseColor = glm::mix(col1, col2, t * 5.0f);
+    } else if (t < 0.4f) {
+        baseColor = glm::mix(col2, col3, (t - 0.2f) * 5.0f);
+    } else if (t < 0.6f) {
+        baseColor = glm::mix(col3, col4, (t - 0.4f) * 5.0f);
+    } else if (t < 0.8f) {
+        baseColor = glm::mix(col4, col5, (t - 0.6f) * 5.0f);
+    } else {
+        baseColor = glm::mix(col5, col1, (t - 0.8f) * 5.0f);
+    }
+
+    float normalVar = glm::dot(normal, glm::vec3(0.577f)) * 0.5f + 0.5f;
+    baseColor = glm::mix(baseColor * 0.8f, baseColor * 1.2f, normalVar);
+
+    float sparkle = std::pow(std::abs(std::sin(p.x * 50.0f) * std::sin(p.y * 50.0f) * std::sin(p.z * 50.0f)), 20.0f);
+    baseColor += glm::vec3(sparkle * 0.3f);
+
+    return baseColor;
+}
+
+glm::vec3 calculateLighting(const glm::vec3& p, const glm::vec3& normal, const glm::vec3& rd,
+                            float ao, const FractalParams& params) {
+    float time = params.time;
+    glm::vec3 lightPos1(std::sin(time * 0.3f) * 10.0f, 5.0f, std::cos(time * 0.3f) * 10.0f);
+    glm::vec3 lightPos2(-5.0f, 8.0f, -5.0f);
+    glm::vec3 lightPos3(5.0f, -3.0f, 8.0f);
+
+    glm::vec3 lightDir1 = glm::normalize(lightPos1 - p);
+    glm::vec3 lightDir2 = glm::normalize(lightPos2 - p);
+    glm::vec3 lightDir3 = glm::normalize(lightPos3 - p);
+
+    float shadow1 = calcSoftShadow(p + normal * 0.002f, lightDir1, 0.02f, 10.0f, params);
+
+    glm::vec3 ambient(0.2f, 0.2f, 0.25f);
+
+    float diff1 = std::max(glm::dot(normal, lightDir1), 0.0f);
+    float diff2 = std::max(glm::dot(normal, lightDir2), 0.0f);
+    float diff3 = std::max(glm::dot(normal, lightDir3), 0.0f);
+
+    glm::vec3 diffuse(0.0f);
+    diffuse += diff1 * glm::vec3(1.0f, 0.95f, 0.9f) * 0.6f * shadow1;
+    diffuse += diff2 * glm::vec3(0.9f, 0.95f, 1.0f) * 0.4f;
+    diffuse += diff3 * glm::vec3(1.0f, 0.9f, 0.85f) * 0.3f;
+
+    glm::vec3 reflectDir1 = glm::reflect(-lightDir1, normal);
+    float spec1 = std::pow(std::max(glm::dot(-rd, reflectDir1), 0.0f), 32.0f);
+    glm::vec3 specular = spec1 * glm::vec3(1.0f, 1.0f, 1.0f) * 0.4f * shadow1;
+
+    float rim = 1.0f - std::max(glm::dot(-rd, normal), 0.0f);
+    rim = std::pow(rim, 4.0f);
+    glm::vec3 rimColor = rim * glm::vec3(0.3f, 0.5f, 0.7f) * 0.5f;
+
+    float skyLight = std::max(0.0f, 0.5f + 0.5f * normal.y);
+    glm::vec3 skyLightColor = glm::vec3(0.3f, 0.4f, 0.6f) * skyLight * 0.3f;
+
+    return (ambient + diffuse + specular + rimColor + skyLightColor) * ao;
+}
+
+glm::vec3 skyColor(const glm::vec3& rd) {
+    glm::vec3 worldDir = rd;
+
+    glm::vec2 starUV = glm::vec2(
+        std::atan2(worldDir.z, worldDir.x),
+        std::asin(worldDir.y)
+    ) * 10.0f;
+
+    float star = 0.0f;
+    for (int i = 0; i < 3; i++) {
+        glm::vec2 gridUV = starUV * (float(i + 1) * 3.0f);
+        glm::vec2 gridID = glm::floor(gridUV);
+        float hash = glm::fract(std::sin(glm::dot(gridID, glm::vec2(12.9898f, 78.233f))) * 43758.5453f);
+
+        if (hash > 0.98f) {
+            glm::vec2 cellUV = glm::fract(gridUV) - 0.5f;
+            float d = glm::length(cellUV);
+            star += glm::smoothstep(0.05f, 0.0f, d) * (hash - 0.98f) * 50.0f;
+        }
+    }
+
+    float gradient = std::pow(std::abs(worldDir.y) * 0.5f + 0.5f, 2.0f);
+    glm::vec3 color = glm::mix(glm::vec3(0.01f, 0.01f, 0.02f), glm::vec3(0.02f, 0.02f, 0.05f), gradient);
+    color += glm::vec3(star) * glm::vec3(1.0f, 0.95f, 0.9f);
+    return color;
+}
+
+glm::vec3 shadePixel(const glm::vec3& ro, const glm::vec3& rd, const MarchResult& march,
+                     const FractalParams& params, float pixelCone) {
+    glm::vec3 color;
+    float dist = march.depth;
+
+    if (march.hit && dist < farLimit(params)) {
+        glm::vec3 p = ro + rd * dist;
+        glm::vec3 normal = calcNormal(p, hitEpsilon(dist, pixelCone, params), params);
+
+        float ao = calcAO(p, normal, params);
+        glm::vec3 baseColor = getColor(p, normal, march.orbitTrap);
+        glm::vec3 lighting = calculateLighting(p, normal, rd, ao, params);
+
+        color = baseColor * lighting;
+
+        float depthFade = std::exp(-dist * 0.01f);
+        color *= glm::mix(0.5f, 1.0f, depthFade);
+    } else {
+        color = skyColor(rd);
+    }
+
+    return glm::pow(color, glm::vec3(1.0f / 2.2f));
+}
@@ -0,0 +1,95 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned i = 0; i < threadCount; i++)
+        queues.push_back(std::make_unique<WorkQueue>());
+
+    for (unsigned i = 0; i < threadCount; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0)
+        return;
+
+    remaining.store(count);
+
+    size_t workerCount = queues.size();
+    size_t run = (count + workerCount - 1) / workerCount;
+    for (size_t w = 0; w < workerCount; w++) {
+        std::lock_guard<std::mutex> lock(queues[w]->mutex);
+        size_t begin = std::min(count, w * run);
+        size_t end = std::min(count, begin + run);
+        for (size_t i = begin; i < end; i++)
+            queues[w]->items.push_back(Task{ &fn, i });
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    generation++;
+    wake.notify_all();
+
+    finished.wait(lock, [this] { return remaining.load() == 0; });
+}
+
+bool ThreadPool::popOrSteal(unsigned index, Task& task) {
+    {
+        WorkQueue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.items.empty()) {
+            task = own.items.front();
+            own.items.pop_front();
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < queues.size(); offset++) {
+        WorkQueue& victim = *queues[(index + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.items.empty()) {
+            task = victim.items.back();
+            victim.items.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned index) {
+    size_t seenGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping)
+                return;
+            seenGeneration = generation;
+        }
+
+        Task task;
+        while (popOrSteal(index, task)) {
+            (*task.fn)(task.index);
+
+            if (remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.notify_all();
+            }
+        }
+    }
+}
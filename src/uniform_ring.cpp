@@ -0,0 +1,80 @@
+#include "uniform_ring.h"
+#include <cstring>
+#include <iostream>
+
+UniformRing::UniformRing(GLsizeiptr blockSize, GLuint binding, int slots)
+    : binding(binding), size(blockSize), stride(blockSize) {
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+
+    if (GLAD_GL_VERSION_4_4 && slots > 1) {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        stride = (blockSize + alignment - 1) / alignment * alignment;
+
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, stride * slots, nullptr, flags);
+        mapped = static_cast<char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, stride * slots, flags));
+        if (!mapped) {
+            // Storage is immutable now; start over with a plain buffer.
+            std::cerr << "ERROR::UNIFORM_RING::MAP_FAILED, using glBufferSubData" << std::endl;
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            glDeleteBuffers(1, &buffer);
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        }
+    }
+
+    if (mapped) {
+        fences.assign(slots, nullptr);
+    } else {
+        stride = blockSize;
+        glBufferData(GL_UNIFORM_BUFFER, blockSize, nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformRing::~UniformRing() {
+    for (GLsync sync : fences)
+        if (sync)
+            glDeleteSync(sync);
+
+    if (mapped) {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+void UniformRing::write(const void* data) {
+    if (!mapped) {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, 0, size);
+        return;
+    }
+
+    slot = (slot + 1) % static_cast<int>(fences.size());
+    if (GLsync sync = fences[slot]) {
+        // Only blocks when the GPU is more than fences.size() frames behind.
+        while (glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+        glDeleteSync(sync);
+        fences[slot] = nullptr;
+    }
+
+    std::memcpy(mapped + slot * stride, data, size);
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, slot * stride, size);
+}
+
+void UniformRing::fence() {
+    if (!mapped)
+        return;
+
+    // A region stays bound across frames with unchanged data, so the fence
+    // must follow the most recent draw that read it.
+    if (fences[slot])
+        glDeleteSync(fences[slot]);
+    fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,22 @@
+#version 410 core
+
+// One estimate per fragment for parity_test.cpp: points holds a world-space
+// point and a fold iteration count per texel; the result is sceneSDF()'s
+// distance and orbit trap there, and mandelboxDE()'s distance at the same
+// point taken as object space.
+
+layout(location = 0) out vec4 Result;
+
+#include "../shaders/frame_uniforms.glsl"
+#include "../shaders/scene.glsl"
+
+uniform sampler2D points;
+
+void main() {
+    vec4 point = texelFetch(points, ivec2(gl_FragCoord.xy), 0);
+    float trap;
+    float dist = sceneSDF(point.xyz, point.w, trap);
+    float objectTrap;
+    float objectDist = mandelboxDE(point.xyz, point.w, objectTrap);
+    Result = vec4(dist, trap, objectDist, 1.0);
+}
@@ -0,0 +1,438 @@
+// Parity of the host port with the GLSL it mirrors: mandelboxDE() and
+// sceneSDF() point by point against tests/de_parity.glsl, and rayMarch()
+// through whole CpuRenderer frames against fragment.glsl. With EGL the
+// shaders run live; every run also checks against output recorded from them
+// in the data directory, so machines without a GL driver still catch drift.
+// With EGL it also checks that a second program built from the same sources
+// loads from the binary cache instead of recompiling.
+//
+//   parity_test <data dir>             compare
+//   parity_test --record <data dir>    rewrite the recordings from the GL side
+
+#include "cpu_renderer.h"
+#include "fractal.h"
+#include "image_io.h"
+#include "render_job.h"
+
+#ifdef FRACTAL_HAVE_EGL
+#include "offscreen_context.h"
+#include "render_target.h"
+#include "shader_preprocessor.h"
+#include "shader_renderer.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Points per estimate case.
+static const int ESTIMATE_POINTS = 1024;
+// GLSL does not require division, square root, sin or cos to be correctly
+// rounded, so the estimates may differ by a few ulps, which the folds carry
+// along. Right at the surface they can grow that past ESTIMATE_TOLERANCE, so
+// a few points per case may; a real divergence moves most of them.
+static const float ESTIMATE_TOLERANCE = 1e-4f;
+static const double MAX_DIFFERENT_POINTS = 0.005;
+// A channel counts as different when it is more than this many 8-bit steps
+// off; at most MAX_DIFFERENT_CHANNELS of them are allowed per frame, for
+// rays that graze the surface and land either side of it.
+static const int CHANNEL_TOLERANCE = 8;
+static const double MAX_DIFFERENT_CHANNELS = 0.002;
+
+struct EstimateCase {
+    const char* name;
+    FractalParams params;
+};
+
+struct RenderCase {
+    const char* name;
+    FrameJob job;
+    float relaxation;
+};
+
+static std::vector<EstimateCase> estimateCases() {
+    std::vector<EstimateCase> cases(3);
+    cases[0].name = "default";
+    cases[1].name = "zoomed-rotated";
+    cases[1].params.scale = 0.25f;
+    cases[1].params.autoRotate = true;
+    cases[1].params.time = 7.0f;
+    cases[2].name = "five-iterations";
+    cases[2].params.maxIterations = 5;
+    return cases;
+}
+
+static std::vector<RenderCase> renderCases() {
+    std::vector<RenderCase> cases(6);
+    for (RenderCase& c : cases) {
+        c.job.width = 96;
+        c.job.height = 54;
+        c.relaxation = 1.0f;
+    }
+    cases[0].name = "outside";
+    cases[1].name = "inside";
+    cases[1].job.mantissa = glm::vec3(0.3f, 0.2f, 1.1f);
+    cases[1].job.exponent = -1;
+    cases[1].job.yaw = -120.0f;
+    cases[1].job.pitch = 10.0f;
+    cases[2].name = "rotated";
+    cases[2].job.autoRotate = true;
+    cases[2].job.time = 20.0f;
+    cases[2].job.maxIterations = 9;
+    cases[3].name = "relaxed";
+    cases[3].relaxation = 1.6f;
+    // Below 1 is the plain tracer.
+    cases[4].name = "unrelaxed";
+    cases[4].relaxation = 0.0f;
+    cases[5].name = "no-iterations";
+    cases[5].job.maxIterations = 0;
+    return cases;
+}
+
+// World-space points around the fractal with iteration counts up to the
+// case's maximum, fractional ones included.
+static std::vector<glm::vec4> estimatePoints(const FractalParams& params) {
+    const float counts[] = { 0.5f, 1.0f, 2.5f, 7.25f, 12.75f };
+    uint32_t state = 12345u;
+    auto next = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<float>(state >> 8) / 16777216.0f;
+    };
+
+    std::vector<glm::vec4> points(ESTIMATE_POINTS);
+    for (int i = 0; i < ESTIMATE_POINTS; i++) {
+        glm::vec3 p = (glm::vec3(next(), next(), next()) * 2.0f - 1.0f) * 3.0f * params.scale;
+        float iterations = static_cast<float>(params.maxIterations);
+        if (i % 6 != 0)
+            iterations = std::min(counts[i % 6 - 1], iterations);
+        points[i] = glm::vec4(p, iterations);
+    }
+    return points;
+}
+
+// sceneSDF() distance and trap, then mandelboxDE() distance, per point.
+static std::vector<glm::vec3> hostEstimates(const FractalParams& params, const std::vector<glm::vec4>& points) {
+    std::vector<glm::vec3> results(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        glm::vec3 p(points[i]);
+        float trap, objectTrap;
+        float dist = sceneSDF(p, params, points[i].w, trap);
+        float objectDist = mandelboxDE(p, points[i].w, objectTrap);
+        results[i] = glm::vec3(dist, trap, objectDist);
+    }
+    return results;
+}
+
+static bool closeEnough(float a, float b) {
+    return std::abs(a - b) <= ESTIMATE_TOLERANCE * std::max(1.0f, std::max(std::abs(a), std::abs(b)));
+}
+
+static bool compareEstimates(const EstimateCase& c, const std::vector<glm::vec4>& points,
+                             const std::vector<glm::vec3>& host, const std::vector<glm::vec3>& glsl,
+                             const char* source) {
+    int failures = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        if (closeEnough(host[i].x, glsl[i].x) && closeEnough(host[i].y, glsl[i].y) &&
+            closeEnough(host[i].z, glsl[i].z))
+            continue;
+        if (failures++ < 5) {
+            std::printf("  (%g, %g, %g) x %g: host %g %g %g, GLSL %g %g %g\n", points[i].x, points[i].y,
+                        points[i].z, points[i].w, host[i].x, host[i].y, host[i].z, glsl[i].x, glsl[i].y,
+                        glsl[i].z);
+        }
+    }
+    std::printf("%s estimates %s: %d of %zu points differ\n", source, c.name, failures, points.size());
+    return static_cast<double>(failures) <= MAX_DIFFERENT_POINTS * static_cast<double>(points.size());
+}
+
+static std::vector<glm::vec3> hostRender(const RenderCase& c) {
+    CpuRenderer renderer;
+    renderer.Relaxation = c.relaxation;
+    std::vector<glm::vec3> pixels;
+    renderer.render(makeViewParams(c.job), pixels);
+    return pixels;
+}
+
+static int channelByte(float v) {
+    return static_cast<int>(std::min(std::max(v, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+static bool compareRenders(const RenderCase& c, const std::vector<glm::vec3>& host,
+                           const std::vector<glm::vec3>& glsl, const char* source) {
+    if (host.size() != glsl.size()) {
+        std::printf("%s render %s: size mismatch\n", source, c.name);
+        return false;
+    }
+
+    size_t different = 0;
+    int largest = 0;
+    for (size_t i = 0; i < host.size(); i++) {
+        for (int k = 0; k < 3; k++) {
+            int delta = std::abs(channelByte(host[i][k]) - channelByte(glsl[i][k]));
+            largest = std::max(largest, delta);
+            if (delta > CHANNEL_TOLERANCE)
+                different++;
+        }
+    }
+    size_t channels = host.size() * 3;
+    bool ok = static_cast<double>(different) <= MAX_DIFFERENT_CHANNELS * static_cast<double>(channels);
+    std::printf("%s render %s: %zu of %zu channels differ by more than %d/255 (largest %d)\n", source, c.name,
+                different, channels, CHANNEL_TOLERANCE, largest);
+    return ok;
+}
+
+static std::string estimatePath(const std::string& dir) {
+    return dir + "/de_parity.txt";
+}
+
+static std::string renderPath(const std::string& dir, const RenderCase& c) {
+    return dir + "/render_" + c.name + ".ppm";
+}
+
+// One line per point: case, then the results as hex floats so they round-trip
+// exactly. Points are regenerated from the case.
+static bool writeEstimates(const std::string& path, const std::vector<std::vector<glm::vec3>>& results) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::cerr << "ERROR::PARITY::CANNOT_WRITE: " << path << std::endl;
+        return false;
+    }
+    for (size_t c = 0; c < results.size(); c++) {
+        for (const glm::vec3& r : results[c])
+            std::fprintf(file, "%zu %a %a %a\n", c, r.x, r.y, r.z);
+    }
+    std::fclose(file);
+    return true;
+}
+
+static bool readEstimates(const std::string& path, size_t caseCount, std::vector<std::vector<glm::vec3>>& results) {
+    std::FILE* file = std::fopen(path.c_str(), "r");
+    if (!file) {
+        std::cerr << "ERROR::PARITY::CANNOT_READ: " << path << std::endl;
+        return false;
+    }
+    results.assign(caseCount, std::vector<glm::vec3>());
+    size_t c;
+    glm::vec3 r;
+    while (std::fscanf(file, "%zu %a %a %a", &c, &r.x, &r.y, &r.z) == 4 && c < caseCount)
+        results[c].push_back(r);
+    std::fclose(file);
+    return true;
+}
+
+// Reads the binary PPM writePPM() produces back to colours in [0, 1].
+static bool readPPM(const std::string& path, int width, int height, std::vector<glm::vec3>& pixels) {
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    int w = 0, h = 0, maxValue = 0;
+    file >> magic >> w >> h >> maxValue;
+    file.get();
+    if (!file || magic != "P6" || w != width || h != height || maxValue != 255) {
+        std::cerr << "ERROR::PARITY::CANNOT_READ: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> bytes(static_cast<size_t>(w) * h * 3);
+    file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        std::cerr << "ERROR::PARITY::CANNOT_READ: " << path << std::endl;
+        return false;
+    }
+    pixels.resize(static_cast<size_t>(w) * h);
+    for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] = glm::vec3(bytes[3 * i], bytes[3 * i + 1], bytes[3 * i + 2]) / 255.0f;
+    return true;
+}
+
+#ifdef FRACTAL_HAVE_EGL
+static const char* ESTIMATE_VERTEX = R"(#version 410 core
+void main() {
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 4.0 - 1.0;
+    gl_Position = vec4(corner, 0.0, 1.0);
+}
+)";
+
+// Evaluates tests/de_parity.glsl once per point, in a row of fragments.
+static bool glslEstimates(const FractalParams& params, const std::vector<glm::vec4>& points,
+                          std::vector<glm::vec3>& results) {
+    std::string fragmentCode, error;
+    if (!preprocessShader(PARITY_SHADER_PATH, ShaderDefines(), fragmentCode, error)) {
+        std::cerr << "ERROR::PARITY::SHADER: " << error << std::endl;
+        return false;
+    }
+    std::unique_ptr<Shader> shader = Shader::fromSource(ESTIMATE_VERTEX, fragmentCode);
+    if (!shader->linked())
+        return false;
+
+    FrameUniforms block{};
+    block.time = params.time;
+    block.scale = params.scale;
+    block.maxIterations = params.maxIterations;
+    block.resolution = glm::vec3(static_cast<float>(points.size()), 1.0f, 0.0f);
+    block.autoRotate = params.autoRotate ? 1 : 0;
+
+    GLuint buffer, texture, vao;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(block), &block, GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, buffer);
+    shader->bindUniformBlock("FrameUniforms", 0);
+
+    const GLsizei count = static_cast<GLsizei>(points.size());
+    RenderTarget target;
+    if (!target.resize(count, 1)) {
+        glDeleteBuffers(1, &buffer);
+        return false;
+    }
+
+    glGenTextures(1, &texture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, count, 1, 0, GL_RGBA, GL_FLOAT, points.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    target.bind();
+    glViewport(0, 0, count, 1);
+    shader->use();
+    shader->setInt("points", 0);
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+    target.readPixels(results);
+
+    glDeleteTextures(1, &texture);
+    glDeleteBuffers(1, &buffer);
+    return true;
+}
+
+// Builds fragment.glsl twice against an empty cache directory: the first
+// compiles and writes the binary, the second must load it and leave it alone.
+static bool checkBinaryCache() {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats == 0) {
+        std::printf("binary cache: driver has no program binary formats, skipped\n");
+        return true;
+    }
+
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "fractal_parity_cache";
+    std::error_code error;
+    std::filesystem::remove_all(dir, error);
+    Shader::setCacheDirectory(dir.string());
+
+    Shader first(SHADER_PATH "vertex.glsl", SHADER_PATH "fragment.glsl");
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, error))
+        files.push_back(entry.path());
+    if (!first.linked() || first.fromCache() || files.size() != 1) {
+        std::cerr << "ERROR::PARITY::CACHE_NOT_WRITTEN: " << dir << std::endl;
+        return false;
+    }
+    const auto written = std::filesystem::last_write_time(files[0], error);
+
+    Shader second(SHADER_PATH "vertex.glsl", SHADER_PATH "fragment.glsl");
+    bool ok = second.linked() && second.fromCache() && std::filesystem::last_write_time(files[0], error) == written;
+    std::printf("binary cache: second build %s\n", ok ? "loaded from the cache" : "recompiled");
+    std::filesystem::remove_all(dir, error);
+    return ok;
+}
+
+static bool glslRender(const RenderCase& c, std::vector<glm::vec3>& pixels) {
+    ShaderRenderer renderer;
+    renderer.Relaxation = c.relaxation;
+    RenderTarget target;
+    if (!target.resize(c.job.width, c.job.height))
+        return false;
+    target.bind();
+    renderer.draw(makeViewParams(c.job));
+    target.readPixels(pixels);
+    return true;
+}
+#endif
+
+int main(int argc, char** argv) {
+    bool record = argc == 3 && std::string(argv[1]) == "--record";
+    if (argc != 2 && !record) {
+        std::cerr << "Usage: parity_test [--record] <data dir>" << std::endl;
+        return 2;
+    }
+    const std::string dataDir = argv[argc - 1];
+    const std::vector<EstimateCase> estimates = estimateCases();
+    const std::vector<RenderCase> renders = renderCases();
+
+    bool live = false;
+#ifdef FRACTAL_HAVE_EGL
+    OffscreenContext context;
+    live = context.create();
+    if (live)
+        std::printf("GLSL side: %s\n", context.renderer());
+#endif
+    if (record && !live) {
+        std::cerr << "ERROR::PARITY::RECORD_NEEDS_GL" << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+#ifdef FRACTAL_HAVE_EGL
+    if (live)
+        ok = checkBinaryCache();
+#endif
+    std::vector<std::vector<glm::vec3>> recorded;
+    if (!record && !readEstimates(estimatePath(dataDir), estimates.size(), recorded))
+        return 1;
+
+    std::vector<std::vector<glm::vec3>> liveEstimates(estimates.size());
+    for (size_t c = 0; c < estimates.size(); c++) {
+        std::vector<glm::vec4> points = estimatePoints(estimates[c].params);
+        std::vector<glm::vec3> host = hostEstimates(estimates[c].params, points);
+#ifdef FRACTAL_HAVE_EGL
+        if (live) {
+            if (!glslEstimates(estimates[c].params, points, liveEstimates[c]))
+                return 1;
+            ok = compareEstimates(estimates[c], points, host, liveEstimates[c], "live") && ok;
+        }
+#endif
+        if (!record) {
+            if (recorded[c].size() != points.size()) {
+                std::cerr << "ERROR::PARITY::RECORDING_MISMATCH: " << estimates[c].name << std::endl;
+                return 1;
+            }
+            ok = compareEstimates(estimates[c], points, host, recorded[c], "recorded") && ok;
+        }
+    }
+    if (record && !writeEstimates(estimatePath(dataDir), liveEstimates))
+        return 1;
+
+    for (const RenderCase& c : renders) {
+        std::vector<glm::vec3> host = hostRender(c);
+#ifdef FRACTAL_HAVE_EGL
+        if (live) {
+            std::vector<glm::vec3> glsl;
+            if (!glslRender(c, glsl))
+                return 1;
+            ok = compareRenders(c, host, glsl, "live") && ok;
+            if (record && !writePPM(renderPath(dataDir, c), c.job.width, c.job.height, glsl))
+                return 1;
+        }
+#endif
+        if (!record) {
+            std::vector<glm::vec3> glsl;
+            if (!readPPM(renderPath(dataDir, c), c.job.width, c.job.height, glsl))
+                return 1;
+            ok = compareRenders(c, host, glsl, "recorded") && ok;
+        }
+    }
+
+    std::printf(ok ? "parity: OK\n" : "parity: FAILED\n");
+    return ok ? 0 : 1;
+}